@@ -0,0 +1,181 @@
+#ifndef SGUI_BENCH_COMMON_HPP
+#define SGUI_BENCH_COMMON_HPP
+
+// Shared pieces of the headless benchmarks: a heap allocation counter, a
+// renderer that draws nothing and an input manager fed from a script.
+// Include this from exactly one translation unit per executable, it
+// replaces the global operator new/delete.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#if __has_include(<sys/resource.h>)
+#include <sys/resource.h>
+#define SGUI_BENCH_HAS_RUSAGE
+#endif
+
+#include "simple_gui.hpp"
+
+namespace bench {
+	struct HeapStats {
+		size_t allocations{ 0 };
+		size_t bytes{ 0 };
+		size_t live{ 0 };
+		size_t peak{ 0 };
+	};
+
+	inline HeapStats& heap() {
+		static HeapStats stats;
+		return stats;
+	}
+
+	/// Peak resident set size of the process, in kilobytes (0 if unknown)
+	inline long maxResidentKB() {
+#ifdef SGUI_BENCH_HAS_RUSAGE
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss;
+#else
+		return 0;
+#endif
+	}
+
+	using Clock = sgui::StatsClock;
+
+	class NullRenderer : public sgui::Renderer {
+	public:
+		inline void* loadFont(const sgui::byte* bits, int width, int height) override {
+			return &m_font;
+		}
+
+		inline void processCommand(const Command& cmd) override {
+			m_processed++;
+		}
+
+		inline void processCommands(const Command* cmds, size_t count) override {
+			for (size_t i = 0; i < count; i++) m_checksum += cmds[i].points[0].x + cmds[i].type;
+			m_processed += count;
+		}
+
+		int m_font{ 0 };
+		size_t m_processed{ 0 };
+		size_t m_checksum{ 0 };
+	};
+
+	struct ScriptedEvent {
+		enum Type {
+			MouseMove = 0,
+			MouseDown,
+			MouseUp,
+			KeyDown,
+			KeyUp,
+			Text
+		} type{ MouseMove };
+
+		int x{ 0 }, y{ 0 };
+		int button{ 1 };
+		sgui::Key key{ sgui::KeyCount };
+		char chr{ 0 };
+	};
+
+	/// Input manager driven by ScriptedEvent payloads and a frame clock
+	class ScriptedInput : public sgui::InputManager {
+	public:
+		inline void init(std::array<int, sgui::KeyCount>& keymap) override {
+			for (int i = 0; i < sgui::KeyCount; i++) keymap[i] = i;
+		}
+
+		inline int time() override { return m_time; }
+
+		inline void processEvents(void* udata) override {
+			const ScriptedEvent& event = *((ScriptedEvent*)udata);
+			switch (event.type) {
+				case ScriptedEvent::MouseMove:
+					queueMouseMove(event.x, event.y, m_time);
+					break;
+				case ScriptedEvent::MouseDown:
+					queueMouseButton(event.button, true, event.x, event.y, m_time);
+					break;
+				case ScriptedEvent::MouseUp:
+					queueMouseButton(event.button, false, event.x, event.y, m_time);
+					break;
+				case ScriptedEvent::KeyDown:
+					queueKey(translateKey(event.key), true, m_time);
+					break;
+				case ScriptedEvent::KeyUp:
+					queueKey(translateKey(event.key), false, m_time);
+					break;
+				case ScriptedEvent::Text: {
+					const char text[2] = { event.chr, 0 };
+					queueText(text, m_time);
+				} break;
+			}
+		}
+
+		inline void setClipboardText(const std::string& text) override { m_clipboard = text; }
+		inline std::string getClipboardText() override { return m_clipboard; }
+
+		inline void setTime(int time) { m_time = time; }
+
+		inline void move(int x, int y) { send({ ScriptedEvent::MouseMove, x, y }); }
+		inline void press(int x, int y) { send({ ScriptedEvent::MouseDown, x, y }); }
+		inline void release(int x, int y) { send({ ScriptedEvent::MouseUp, x, y }); }
+
+		inline void key(sgui::Key key, bool down) {
+			ScriptedEvent e{};
+			e.type = down ? ScriptedEvent::KeyDown : ScriptedEvent::KeyUp;
+			e.key = key;
+			send(e);
+		}
+
+		inline void type(char c) {
+			ScriptedEvent e{};
+			e.type = ScriptedEvent::Text;
+			e.chr = c;
+			send(e);
+		}
+
+	private:
+		std::string m_clipboard;
+		int m_time{ 0 };
+
+		inline void send(ScriptedEvent e) { processEvents(&e); }
+	};
+}
+
+// Replacement allocation functions, counting every heap allocation.
+// The size is kept in a header in front of the block to track live bytes.
+namespace bench {
+	constexpr size_t HeapHeader = alignof(std::max_align_t);
+}
+
+void* operator new(size_t size) {
+	bench::HeapStats& stats = bench::heap();
+	stats.allocations++;
+	stats.bytes += size;
+	stats.live += size;
+	if (stats.live > stats.peak) stats.peak = stats.live;
+
+	unsigned char* block = (unsigned char*) std::malloc(size + bench::HeapHeader);
+	if (block == nullptr) throw std::bad_alloc();
+	*((size_t*)block) = size;
+	return block + bench::HeapHeader;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void* ptr) noexcept {
+	if (ptr == nullptr) return;
+	unsigned char* block = ((unsigned char*)ptr) - bench::HeapHeader;
+	bench::heap().live -= *((size_t*)block);
+	std::free(block);
+}
+
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+
+#endif // SGUI_BENCH_COMMON_HPP
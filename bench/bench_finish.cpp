@@ -0,0 +1,35 @@
+// Measures Renderer::finish over growing command counts. Cost per command
+// should stay flat from 1k to 1M commands.
+#include "bench_common.hpp"
+
+using namespace sgui;
+using bench::NullRenderer;
+
+static void record(NullRenderer& ren, int count) {
+	for (int i = 0; i < count; i++) {
+		const Rect r(i % 640, (i * 7) % 480, 32, 16);
+		if (i % 2 == 0) ren.rect(r, Color(0x555555FF), true);
+		else ren.image(&ren.m_font, Rect((i % 96) * 8, 0, 8, 16), Rect(r.x, r.y, 8, 16), Color(0xFFFFFFFF));
+	}
+}
+
+int main(int argc, char** argv) {
+	const int maxCommands = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+	NullRenderer ren;
+	std::printf("%12s %14s %14s\n", "commands", "finish (us)", "ns / command");
+	for (int count = 1000; count <= maxCommands; count *= 10) {
+		const int frames = std::max(3, 2000000 / count);
+		double total = 0.0;
+		for (int i = 0; i < frames; i++) {
+			record(ren, count);
+			const auto start = bench::Clock::now();
+			ren.finish(640, 480);
+			const auto stop = bench::Clock::now();
+			total += elapsedMicros(start, stop);
+		}
+		const double perFrame = total / frames;
+		std::printf("%12d %14.1f %14.2f\n", count, perFrame, perFrame * 1000.0 / count);
+	}
+	return ren.m_checksum == 0 ? 1 : 0;
+}
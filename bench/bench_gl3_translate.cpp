@@ -0,0 +1,284 @@
+// Compares GL3Renderer command translation against the former Glyph based
+// path on a text heavy screen (50k glyphs by default) and a widget dense one
+// (5k buttons). Only the CPU side is measured: neither renderer touches GL
+// while translating, and the upload in end() is replaced by a checksum.
+#include "bench_common.hpp"
+#include "simple_gui_gl3.hpp"
+
+using namespace sgui;
+
+namespace {
+	constexpr int ScreenWidth = 1920, ScreenHeight = 1080;
+
+	/// The translation path GL3Renderer used before, kept here as the baseline
+	class LegacyGlyphRenderer : public Renderer {
+	public:
+		struct Vert { float x, y, u, v, r, g, b, a; };
+		struct Batch { int offset{ 0 }, length{ 0 }; GLenum prim{ 0 }; Texture tex{}; Rect scissor{ 0, 0, 0, 0 }; };
+		struct Glyph { std::vector<Vert> vertices; Texture tex{}; Rect scissor{ 0, 0, 0, 0 }; GLuint prim{ 0 }; };
+
+		inline void* loadFont(const byte* bits, int width, int height) override { return nullptr; }
+
+		inline void end(int width, int height) override {
+			if (m_glyphs.empty()) return;
+
+			std::vector<Vert> verts;
+			verts.reserve(100000);
+
+			Glyph first = m_glyphs[0];
+			Batch b{};
+			b.length = first.vertices.size();
+			b.prim = first.prim;
+			b.tex = first.tex;
+			b.scissor = first.scissor;
+			m_batches.push_back(b);
+			verts.insert(verts.end(), first.vertices.begin(), first.vertices.end());
+
+			int off = 0;
+			for (size_t i = 1; i < m_glyphs.size(); i++) {
+				Glyph curr = m_glyphs[i];
+				Glyph prev = m_glyphs[i - 1];
+				if (curr.tex.id != prev.tex.id || curr.prim != prev.prim) {
+					off += m_batches.back().length;
+					Batch b{};
+					b.offset = off;
+					b.length = curr.vertices.size();
+					b.prim = curr.prim;
+					b.tex = curr.tex;
+					b.scissor = curr.scissor;
+					m_batches.push_back(b);
+				} else {
+					m_batches.back().length += curr.vertices.size();
+				}
+				verts.insert(verts.end(), curr.vertices.begin(), curr.vertices.end());
+			}
+
+			for (const Vert& v : verts) m_checksum += v.x + v.u;
+			m_vertices = verts.size();
+			m_bytes = verts.size() * sizeof(Vert);
+			m_batchCount = m_batches.size();
+			m_batches.clear();
+			m_glyphs.clear();
+		}
+
+		inline void processCommand(const Command& cmd) override {
+			Glyph g;
+			g.tex.id = 0;
+			g.prim = 0xFF;
+
+			const float cr = cmd.color.r / 255.0f,
+						cg = cmd.color.g / 255.0f,
+						cb = cmd.color.b / 255.0f,
+						ca = cmd.color.a / 255.0f;
+			const float x1 = cmd.points[0].x, y1 = cmd.points[0].y,
+						x2 = cmd.points[1].x, y2 = cmd.points[1].y;
+
+			switch (cmd.type) {
+				case Command::CmdDrawLine: {
+					g.prim = GL_LINES;
+					g.vertices.push_back(Vert{ x1, y1, 0, 0, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y2, 0, 0, cr, cg, cb, ca });
+				} break;
+				case Command::CmdDrawRect: {
+					g.prim = GL_LINES;
+					g.vertices.push_back(Vert{ x1, y1, 0, 0, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y1, 1, 0, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y1, 1, 0, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y2, 1, 1, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y2, 1, 1, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x1, y2, 0, 1, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x1, y2, 0, 1, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x1, y1, 0, 0, cr, cg, cb, ca });
+				} break;
+				case Command::CmdFillRect: {
+					g.prim = GL_TRIANGLES;
+					g.vertices.push_back(Vert{ x1, y1, 0, 0, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y1, 1, 0, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y2, 1, 1, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y2, 1, 1, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x1, y2, 0, 1, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x1, y1, 0, 0, cr, cg, cb, ca });
+				} break;
+				case Command::CmdDrawImage: {
+					Texture* img = (Texture*) imageOf(cmd);
+					float u1 = float(cmd.src.x) / img->w;
+					float v1 = float(cmd.src.y) / img->h;
+					float u2 = float(cmd.src.x + cmd.src.w) / img->w;
+					float v2 = float(cmd.src.y + cmd.src.h) / img->h;
+
+					g.prim = GL_TRIANGLES;
+					g.tex = *img;
+					g.vertices.push_back(Vert{ x1, y1, u1, v1, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y1, u2, v1, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y2, u2, v2, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x2, y2, u2, v2, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x1, y2, u1, v2, cr, cg, cb, ca });
+					g.vertices.push_back(Vert{ x1, y1, u1, v1, cr, cg, cb, ca });
+				} break;
+				case Command::CmdSetClip: {
+					m_nextClip = Rect(cmd.points[0].x, cmd.points[0].y, cmd.points[1].x - cmd.points[0].x, cmd.points[1].y - cmd.points[0].y);
+				} break;
+				case Command::CmdUnsetClip: {
+					// Used to query GL_VIEWPORT here
+					m_nextClip = Rect(0, 0, ScreenWidth, ScreenHeight);
+				} break;
+				default: break;
+			}
+			g.scissor = m_nextClip;
+			m_glyphs.push_back(g);
+		}
+
+		double m_checksum{ 0.0 };
+		size_t m_vertices{ 0 }, m_bytes{ 0 }, m_batchCount{ 0 };
+
+	private:
+		Rect m_nextClip{ 0, 0, 0, 0 };
+		std::vector<Batch> m_batches;
+		std::vector<Glyph> m_glyphs;
+	};
+
+	/// GL3Renderer with the texture upload, instance upload and draws replaced by a checksum
+	class HeadlessGL3Renderer : public GL3Renderer {
+	public:
+		inline void* loadFont(const byte* bits, int width, int height) override {
+			m_font = Texture{ 1, width, height };
+			return &m_font;
+		}
+
+		inline void end(int width, int height) override {
+			for (const Instance& i : m_instances) m_checksum += i.x1 + i.u1 + i.kind;
+			m_instanceCount = m_instances.size();
+			m_bytes = m_instances.size() * sizeof(Instance);
+			m_batchCount = m_batches.size();
+			m_instances.clear();
+			m_batches.clear();
+		}
+
+		double m_checksum{ 0.0 };
+		size_t m_instanceCount{ 0 }, m_bytes{ 0 }, m_batchCount{ 0 };
+	};
+
+	/**
+	 * Panels of text. The glyph path draws every glyph twice (shadow and
+	 * foreground) as Gui::chr used to, the direct path records a run per row.
+	 */
+	void recordText(Renderer& ren, Texture& font, int glyphs, bool runs) {
+		const int cols = 58, rows = 16;
+		const int panelW = ScreenWidth / 4, panelH = ScreenHeight / 4;
+		char row[cols];
+		int drawn = 0;
+		for (int panel = 0; drawn < glyphs; panel++) {
+			const Rect bounds((panel % 4) * panelW, ((panel / 4) % 4) * panelH, panelW, panelH);
+			ren.rect(bounds, Color(0x333333FF), true);
+			ren.rect(bounds, Color(0x777777FF));
+			ren.clip(bounds.grow(-2));
+			for (int r = 0; r < rows && drawn < glyphs; r++) {
+				const int x = bounds.x + 2, y = bounds.y + 2 + r * 16;
+				const int count = std::min(cols, glyphs - drawn);
+				for (int i = 0; i < count; i++, drawn++) {
+					// Skips the blank cell 0, every glyph is visible
+					const int cell = 1 + (drawn * 7) % 95;
+					if (runs) {
+						row[i] = char(' ' + cell);
+					} else {
+						const Rect src(cell * 8, 0, 8, 16);
+						ren.image(&font, src, Rect(x + i * 8, y + 1, 8, 16), Color(0x000000FF));
+						ren.image(&font, src, Rect(x + i * 8, y, 8, 16), Color(0xFFFFFFFF));
+					}
+				}
+				if (runs) ren.text(&font, x, y, row, count, Color(0xFFFFFFFF));
+			}
+			ren.unclip();
+		}
+	}
+
+	/**
+	 * Grid of buttons with a short label. Gui used to draw each frame as a
+	 * shadow, a fill and an outline and each glyph twice, it now records a
+	 * single box and a text run.
+	 */
+	void recordWidgets(Renderer& ren, Texture& font, int widgets, bool boxes) {
+		const int w = 64, h = 20, cols = ScreenWidth / (w + 4);
+		const Color base(0x3A3A3AFF), fg(0x747474FF);
+		for (int i = 0; i < widgets; i++) {
+			const Rect r(((i % cols) * (w + 4)) % ScreenWidth, ((i / cols) * (h + 4)) % ScreenHeight, w, h);
+			if (boxes) {
+				ren.box(r, base, fg, 1, 1);
+			} else {
+				ren.rect(Rect(r.x + 1, r.y + 1, r.w, r.h), Color(0.0f, 0.0f, 0.0f, 0.45f), true);
+				ren.rect(r, base, true);
+				ren.rect(r, fg);
+			}
+			char label[6];
+			for (int c = 0; c < 6; c++) {
+				const int cell = 1 + (i + c * 5) % 95;
+				if (boxes) {
+					label[c] = char(' ' + cell);
+				} else {
+					const Rect src(cell * 8, 0, 8, 16);
+					ren.image(&font, src, Rect(r.x + 8 + c * 8, r.y + 3, 8, 16), Color(0x000000FF));
+					ren.image(&font, src, Rect(r.x + 8 + c * 8, r.y + 2, 8, 16), Color(0xFFFFFFFF));
+				}
+			}
+			if (boxes) ren.text(&font, r.x + 8, r.y + 2, label, 6, Color(0xFFFFFFFF));
+		}
+	}
+
+	template <typename R, typename Record>
+	double measure(R& ren, Record record, int frames, size_t& allocations) {
+		double total = 0.0;
+		allocations = 0;
+		for (int i = 0; i < frames + 2; i++) {
+			record(ren);
+			const size_t before = bench::heap().allocations;
+			const auto start = bench::Clock::now();
+			ren.finish(ScreenWidth, ScreenHeight);
+			const auto stop = bench::Clock::now();
+			if (i < 2) continue; // warm up
+			total += elapsedMicros(start, stop);
+			allocations += bench::heap().allocations - before;
+		}
+		allocations /= frames;
+		return total / frames;
+	}
+}
+
+int main(int argc, char** argv) {
+	const int glyphs = argc > 1 ? std::atoi(argv[1]) : 50000;
+	const int frames = argc > 2 ? std::atoi(argv[2]) : 20;
+	const int widgets = argc > 3 ? std::atoi(argv[3]) : 5000;
+
+	Texture font{ 1, fontWidth, fontHeight };
+	HeadlessGL3Renderer direct;
+	Texture* atlas = (Texture*) direct.loadFont(fontAtlas.bits, fontWidth, fontHeight);
+
+	std::printf("%d glyphs, %d widgets, %d frames\n", glyphs, widgets, frames);
+	std::printf("elements are vertices for the glyph path, instances for the direct one\n");
+	std::printf("%-16s %10s %14s %12s %12s %11s %14s\n", "screen/path", "commands", "finish (us)", "elements", "upload (KB)", "draw calls", "allocs/frame");
+
+	bool ok = true;
+	for (int screen = 0; screen < 2; screen++) {
+		const bool text = screen == 0;
+		auto legacyRecord = [&](Renderer& ren) {
+			if (text) recordText(ren, font, glyphs, false);
+			else recordWidgets(ren, font, widgets, false);
+		};
+		auto directRecord = [&](Renderer& ren) {
+			if (text) recordText(ren, *atlas, glyphs, true);
+			else recordWidgets(ren, *atlas, widgets, true);
+		};
+
+		LegacyGlyphRenderer legacy;
+		size_t legacyAllocs = 0, directAllocs = 0;
+		const double legacyTime = measure(legacy, legacyRecord, frames, legacyAllocs);
+		const double directTime = measure(direct, directRecord, frames, directAllocs);
+
+		const char* name = text ? "text" : "widgets";
+		std::printf("%-8s%-8s %10d %14.1f %12zu %12zu %11zu %14zu\n", name, "/glyph", legacy.stats().commands, legacyTime, legacy.m_vertices, legacy.m_bytes / 1024, legacy.m_batchCount, legacyAllocs);
+		std::printf("%-8s%-8s %10d %14.1f %12zu %12zu %11zu %14zu\n", name, "/direct", direct.stats().commands, directTime, direct.m_instanceCount, direct.m_bytes / 1024, direct.m_batchCount, directAllocs);
+		std::printf("%-8s speedup %.2fx, upload %.2fx smaller\n", name, legacyTime / directTime, double(legacy.m_bytes) / direct.m_bytes);
+		ok = ok && direct.m_instanceCount > 0;
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+// Stress test of the threaded input mode. A producer thread posts events at
+// 10 kHz while the GUI thread builds deliberately slow frames. Reports how
+// many events were lost or reordered, how long a post took on the producer
+// and how long events waited for a frame.
+//
+// usage: sgui_bench_input [seconds] [frame ms]
+#include <algorithm>
+#include <thread>
+
+#include "bench_common.hpp"
+
+using namespace sgui;
+using bench::NullRenderer;
+
+/// Posts mouse motion numbered in x, with the time in milliseconds since start
+class StressInput : public InputManager {
+public:
+	inline void init(std::array<int, KeyCount>& keymap) override {
+		for (int i = 0; i < KeyCount; i++) keymap[i] = i;
+	}
+
+	inline int time() override { return int(elapsedMicros(m_start, bench::Clock::now()) / 1000.0); }
+
+	inline void processEvents(void* udata) override {
+		const int sequence = *((int*)udata);
+		if (sequence % 50 == 49) {
+			queueText("\xC3\xA9", time()); // two byte code point, takes one event
+		} else {
+			queueMouseMove(sequence, 0, time());
+		}
+	}
+
+	inline void setClipboardText(const std::string& text) override {}
+	inline std::string getClipboardText() override { return ""; }
+
+private:
+	const bench::Clock::time_point m_start{ bench::Clock::now() };
+};
+
+int main(int argc, char** argv) {
+	const double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+	const int frameMs = argc > 2 ? std::atoi(argv[2]) : 50;
+	const auto period = std::chrono::microseconds(100); // 10 kHz
+
+	StressInput* input = new StressInput();
+	input->setThreaded(true);
+	Gui gui(input, new NullRenderer());
+
+	std::atomic<bool> running{ true };
+	int produced = 0;
+	double postMax = 0.0, postTotal = 0.0;
+	std::thread producer([&]() {
+		auto next = bench::Clock::now();
+		while (running.load(std::memory_order_relaxed)) {
+			const auto start = bench::Clock::now();
+			input->processEvents(&produced);
+			const double took = elapsedMicros(start, bench::Clock::now());
+			postMax = std::max(postMax, took);
+			postTotal += took;
+			produced++;
+
+			next += period;
+			std::this_thread::sleep_until(next);
+		}
+	});
+
+	size_t consumed = 0, dropped = 0, reordered = 0, frames = 0;
+	int lastMove = -1, waitMax = 0;
+	double waitTotal = 0.0;
+	const auto end = bench::Clock::now() + std::chrono::duration<double>(seconds);
+	while (bench::Clock::now() < end) {
+		gui.prepare();
+		const int now = input->time();
+		for (size_t i = 0; i < input->eventCount(); i++) {
+			const InputEvent& e = input->event(i);
+			if (e.type == InputEvent::EventMouseMove) {
+				if (e.x <= lastMove) reordered++;
+				lastMove = e.x;
+			}
+			waitMax = std::max(waitMax, now - e.time);
+			waitTotal += now - e.time;
+		}
+		consumed += input->eventCount();
+
+		gui.pushContainer(0, 0, 640, 480);
+		gui.button("slow frame");
+		gui.popContainer();
+		std::this_thread::sleep_for(std::chrono::milliseconds(frameMs));
+
+		gui.finish(640, 480);
+		dropped += size_t(gui.stats().droppedInputEvents);
+		frames++;
+	}
+	running = false;
+	producer.join();
+
+	// events posted after the last frame are still in the handoff queue
+	gui.prepare();
+	consumed += input->eventCount();
+	gui.finish(640, 480);
+	dropped += size_t(gui.stats().droppedInputEvents);
+
+	std::printf("producer:  %d events in %.1f s (%.0f Hz), post mean %.3f us, max %.3f us\n",
+		produced, seconds, produced / seconds, postTotal / std::max(produced, 1), postMax);
+	std::printf("consumer:  %zu frames of %d ms, %zu events, wait mean %.1f ms, max %d ms\n",
+		frames, frameMs, consumed, waitTotal / std::max<size_t>(consumed, 1), waitMax);
+	std::printf("lost:      %zu dropped, %zu missing, %zu out of order\n",
+		dropped, size_t(produced) - consumed - dropped, reordered);
+	return consumed + dropped == size_t(produced) && reordered == 0 ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+// Measures the Renderer record path (line/rect/image/clip) and counts heap
+// allocations made while recording. In steady state this should be zero.
+#include "bench_common.hpp"
+
+using namespace sgui;
+using bench::NullRenderer;
+
+static void record(NullRenderer& ren, int count) {
+	for (int i = 0; i < count; i++) {
+		const Rect r(i % 640, (i * 7) % 480, 32, 16);
+		switch (i % 5) {
+			case 0: ren.rect(r, Color(0.0f, 0.0f, 0.0f, 0.45f), true); break;
+			case 1: ren.rect(r, Color(0x555555FF)); break;
+			case 2: ren.line(r.x, r.y, r.x + r.w, r.y, Color(0xFFFFFFFF)); break;
+			case 3: ren.image(&ren.m_font, Rect((i % 96) * 8, 0, 8, 16), Rect(r.x, r.y, 8, 16), Color(0xFFFFFFFF)); break;
+			case 4: ren.clip(r); ren.unclip(); break;
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	const int commands = argc > 1 ? std::atoi(argv[1]) : 2000;
+	const int frames = argc > 2 ? std::atoi(argv[2]) : 200;
+	const int warmup = 4;
+
+	NullRenderer ren;
+	for (int i = 0; i < warmup; i++) {
+		record(ren, commands);
+		ren.finish(640, 480);
+	}
+
+	size_t allocations = 0;
+	double recordTime = 0.0;
+	for (int i = 0; i < frames; i++) {
+		const size_t before = bench::heap().allocations;
+		const auto start = bench::Clock::now();
+		record(ren, commands);
+		const auto stop = bench::Clock::now();
+		allocations += bench::heap().allocations - before;
+		recordTime += elapsedMicros(start, stop);
+		ren.finish(640, 480);
+	}
+
+	std::printf("command size:        %zu bytes\n", sizeof(Renderer::Command));
+	std::printf("commands per frame:  %d\n", commands);
+	std::printf("frames:              %d\n", frames);
+	std::printf("record time / frame: %.2f us\n", recordTime / frames);
+	std::printf("allocations:         %zu (%.3f per frame)\n", allocations, double(allocations) / frames);
+	return allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+// Records nested clips across z index changes and replays the sorted command
+// stream the way a backend would, checking that every draw ends up under the
+// clip rectangle it was recorded with. Exits with 1 on the first mismatch.
+//
+// usage: sgui_check_clip_order
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include "simple_gui.hpp"
+
+using namespace sgui;
+
+/// Keeps the commands of every layer, in the order they were submitted
+class CaptureRenderer : public Renderer {
+public:
+	inline void* loadFont(const byte* bits, int width, int height) override { return this; }
+	inline void processCommand(const Command& cmd) override { m_commands.push_back(cmd); }
+
+	std::vector<Command> m_commands;
+};
+
+/// Where a draw was recorded and the clip it was recorded under, w < 0 for none
+struct Expected {
+	int z;
+	Rect clip;
+};
+
+static const Rect Unclipped(0, 0, -1, -1);
+
+class Checker {
+public:
+	inline explicit Checker(CaptureRenderer& renderer) : m_renderer(renderer) {}
+
+	/// Draws a small filled rect, identified by its x, and remembers the clip it needs
+	inline void draw(int z) {
+		const int x = 20 + int(m_expected.size()) * 2;
+		const Rect* clip = m_renderer.clipRect();
+		m_expected[x] = Expected{ z, clip ? *clip : Unclipped };
+		m_renderer.rect(Rect(x, 30, 1, 1), Color(1.0f, 1.0f, 1.0f), true);
+	}
+
+	inline int verify() {
+		int failures = 0, draws = 0;
+		Rect clip = Unclipped;
+		for (const Command& cmd : m_renderer.m_commands) {
+			if (cmd.type == Command::CmdSetClip) {
+				clip = Rect(cmd.points[0].x, cmd.points[0].y, cmd.points[1].x - cmd.points[0].x, cmd.points[1].y - cmd.points[0].y);
+			} else if (cmd.type == Command::CmdUnsetClip) {
+				clip = Unclipped;
+			} else if (cmd.type == Command::CmdFillRect) {
+				const Expected& e = m_expected[cmd.points[0].x];
+				draws++;
+				if (clip.x != e.clip.x || clip.y != e.clip.y || clip.w != e.clip.w || clip.h != e.clip.h) {
+					std::fprintf(stderr, "draw at x %d, z %d: clip %d,%d %dx%d, recorded under %d,%d %dx%d\n",
+						cmd.points[0].x, e.z, clip.x, clip.y, clip.w, clip.h, e.clip.x, e.clip.y, e.clip.w, e.clip.h);
+					failures++;
+				}
+			}
+		}
+		if (draws != int(m_expected.size())) {
+			std::fprintf(stderr, "%d draws submitted, %zu recorded\n", draws, m_expected.size());
+			failures++;
+		}
+		return failures;
+	}
+
+private:
+	CaptureRenderer& m_renderer;
+	std::map<int, Expected> m_expected;
+};
+
+int main() {
+	CaptureRenderer renderer;
+	Checker checker(renderer);
+
+	checker.draw(0);
+	renderer.clip(Rect(10, 10, 200, 100));
+	checker.draw(0);
+
+	renderer.pushZIndex(2);
+		checker.draw(2);
+		renderer.clip(Rect(15, 20, 100, 40));
+			checker.draw(2);
+		renderer.unclip();
+		checker.draw(2);
+	renderer.popZIndex();
+	checker.draw(0);
+
+	renderer.pushZIndex(-1);
+		checker.draw(-1);
+		renderer.clip(Rect(12, 25, 150, 20));
+			checker.draw(-1);
+			renderer.pushZIndex(1);
+				checker.draw(1);
+			renderer.popZIndex();
+			checker.draw(-1);
+		renderer.unclip();
+	renderer.popZIndex();
+	renderer.unclip();
+	checker.draw(0);
+
+	renderer.pushZIndex(3);
+		checker.draw(3);
+	renderer.popZIndex();
+
+	renderer.pushLayer(LayerPopup);
+		renderer.pushZIndex(5);
+			renderer.clip(Rect(18, 28, 40, 10));
+			checker.draw(5);
+			renderer.unclip();
+		renderer.popZIndex();
+	renderer.popLayer();
+	renderer.pushLayer(LayerPopup);
+		checker.draw(0);
+	renderer.popLayer();
+
+	renderer.finish(640, 480);
+
+	const int failures = checker.verify();
+	if (failures) {
+		std::fprintf(stderr, "%d draws under the wrong clip\n", failures);
+		return 1;
+	}
+	std::printf("clip order ok, %zu commands\n", renderer.m_commands.size());
+	return 0;
+}
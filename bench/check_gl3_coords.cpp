@@ -0,0 +1,87 @@
+// Translates draws that reach past the 16 bit instance coordinates with
+// GL3Renderer and checks that none of them wraps around: whatever lies
+// outside the range is culled, whatever reaches into it is clamped.
+// Exits with 1 on the first bad instance.
+//
+// usage: sgui_check_gl3_coords
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "simple_gui_gl3.hpp"
+
+using namespace sgui;
+
+/// GL3Renderer keeping the translated instances instead of uploading them
+class CaptureGL3Renderer : public GL3Renderer {
+public:
+	inline void* loadFont(const byte* bits, int width, int height) override {
+		m_font = Texture{ 1, width, height };
+		return &m_font;
+	}
+
+	inline void end(int width, int height) override {
+		m_captured = m_instances;
+		m_instances.clear();
+		m_batches.clear();
+	}
+
+	std::vector<Instance> m_captured;
+};
+
+int main() {
+	CaptureGL3Renderer renderer;
+	void* font = renderer.loadFont(fontAtlas.bits, fontWidth, fontHeight);
+
+	// 10000 glyphs from x 0 end at 80000, past 32767 and 65536
+	const std::string run(10000, 'A');
+	renderer.text(font, 0, 40, run.data(), run.size(), Color(1.0f, 1.0f, 1.0f), false);
+
+	// both would land on screen if their coordinates wrapped
+	renderer.rect(Rect(70000, 10, 20, 20), Color(1.0f, 0.0f, 0.0f), true);
+	renderer.rect(Rect(-65436, 10, 20, 20), Color(1.0f, 0.0f, 0.0f), true);
+	renderer.rect(Rect(100, 100, 50, 50), Color(0.0f, 1.0f, 0.0f), true);
+
+	// reaches into the range, clamped at its right end
+	renderer.line(10, 200, 40000, 200, Color(1.0f, 1.0f, 1.0f));
+
+	renderer.finish(640, 480);
+
+	int failures = 0, glyphs = 0, boxes = 0, lines = 0;
+	for (const Instance& i : renderer.m_captured) {
+		if (i.x1 > i.x2 || i.y1 > i.y2) {
+			std::fprintf(stderr, "wrapped instance, kind %d: %d,%d - %d,%d\n", i.kind, i.x1, i.y1, i.x2, i.y2);
+			failures++;
+		}
+		if (i.kind == Instance::KindQuad) {
+			if (i.x1 < 0) {
+				std::fprintf(stderr, "glyph at x %d, the run starts at 0\n", i.x1);
+				failures++;
+			}
+			glyphs++;
+		} else if (i.kind == Instance::KindBox) {
+			if (i.x1 != 100) {
+				std::fprintf(stderr, "box at x %d, only the one at 100 is in range\n", i.x1);
+				failures++;
+			}
+			boxes++;
+		} else if (i.kind == Instance::KindLine) {
+			if (i.x1 != 10 || i.x2 != 32767) {
+				std::fprintf(stderr, "line from x %d to %d, expected 10 to 32767\n", i.x1, i.x2);
+				failures++;
+			}
+			lines++;
+		}
+	}
+	if (glyphs == 0 || glyphs > 32768 / 8 + 1 || boxes != 1 || lines != 1) {
+		std::fprintf(stderr, "%d glyphs, %d boxes, %d lines\n", glyphs, boxes, lines);
+		failures++;
+	}
+
+	if (failures) {
+		std::fprintf(stderr, "%d bad instances\n", failures);
+		return 1;
+	}
+	std::printf("gl3 coordinates ok, %zu instances\n", renderer.m_captured.size());
+	return 0;
+}
@@ -0,0 +1,589 @@
+// Headless benchmark harness. Builds synthetic UIs against a null renderer
+// and scripted input for many frames and reports per-frame cost as JSON.
+//
+// usage: sgui_bench [--frames N] [--warmup N] [--scenario NAME]
+//                   [--text-cache BYTES] [--per-frame] [--out FILE]
+//                   [--trace FILE] [--record FILE | --replay FILE]
+//
+// --text-cache sets the capacity of the text layout cache, 0 disables it.
+// --record writes the scenario's input to FILE, --replay drives the scenario
+// with a recording instead of its script, for as many frames as it holds.
+// Both need --scenario.
+// --trace writes a Chrome trace of the library's profiling scopes, which
+// requires building with SGUI_PROFILING (cmake -DSGUI_PROFILING=ON).
+// Exits with 1 if a scenario's own checks failed, e.g. a menu that never opened.
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "simple_gui_record.hpp"
+
+using namespace sgui;
+using namespace bench;
+
+constexpr int ScreenWidth = 1280;
+constexpr int ScreenHeight = 720;
+
+class Scenario {
+public:
+	virtual ~Scenario() = default;
+	virtual const char* name() const = 0;
+	virtual int widgets() const = 0;
+	virtual void script(ScriptedInput& input, int frame) {}
+	virtual void build(Gui& gui, int frame) = 0;
+
+	/// Checks the frame before it is finished, returns what went wrong or nullptr
+	virtual const char* check(const NullRenderer& renderer, int frame) { return nullptr; }
+};
+
+/// A grid of buttons, most of them outside the container
+class ButtonsScenario : public Scenario {
+public:
+	inline ButtonsScenario(int count) {
+		for (int i = 0; i < count; i++) m_labels.push_back("Button " + std::to_string(i));
+	}
+
+	const char* name() const override { return "buttons"; }
+	int widgets() const override { return int(m_labels.size()); }
+
+	void script(ScriptedInput& input, int frame) override {
+		const int x = (frame * 13) % ScreenWidth, y = (frame * 7) % ScreenHeight;
+		input.move(x, y);
+		if (frame % 8 == 0) input.press(x, y);
+		else if (frame % 8 == 1) input.release(x, y);
+	}
+
+	void build(Gui& gui, int frame) override {
+		gui.pushContainer(0, 0, ScreenWidth, ScreenHeight);
+		for (size_t i = 0; i < m_labels.size(); i++) {
+			const int col = int(i % 10), row = int(i / 10);
+			gui.pushLayout(col * 126, row * 26, 122, 24);
+				gui.button(m_labels[i]);
+			gui.popLayout();
+		}
+		gui.popContainer();
+	}
+
+private:
+	std::vector<std::string> m_labels;
+};
+
+/// Columns of sliders, one of them being dragged back and forth
+class SlidersScenario : public Scenario {
+public:
+	inline SlidersScenario(int count) : m_values(count, 0.5f) {}
+
+	const char* name() const override { return "sliders"; }
+	int widgets() const override { return int(m_values.size()); }
+
+	void script(ScriptedInput& input, int frame) override {
+		const int x = 20 + (frame * 9) % 280, y = 16;
+		if (frame % 60 == 0) input.press(x, y);
+		else if (frame % 60 == 59) input.release(x, y);
+		else input.move(x, y);
+	}
+
+	void build(Gui& gui, int frame) override {
+		gui.pushContainer(0, 0, ScreenWidth, ScreenHeight);
+		for (size_t i = 0; i < m_values.size(); i++) {
+			const int col = int(i % 4), row = int(i / 4);
+			gui.pushLayout(col * 310, row * 26, 300, 24);
+				gui.slider(&m_values[i]);
+			gui.popLayout();
+		}
+		gui.popContainer();
+	}
+
+private:
+	std::vector<float> m_values;
+};
+
+/// Edit boxes, the first one focused and receiving keystrokes
+class EditsScenario : public Scenario {
+public:
+	inline EditsScenario(int count) {
+		for (int i = 0; i < count; i++) m_texts.push_back("Edit box #" + std::to_string(i) + ": the quick brown fox");
+	}
+
+	const char* name() const override { return "edits"; }
+	int widgets() const override { return int(m_texts.size()); }
+
+	void script(ScriptedInput& input, int frame) override {
+		if (frame == 0) input.press(20, 14);
+		else if (frame == 1) input.release(20, 14);
+		else if (frame % 5 == 0) {
+			input.key(KeyBackspace, true);
+			input.key(KeyBackspace, false);
+		} else {
+			input.type(char('a' + frame % 26));
+		}
+	}
+
+	void build(Gui& gui, int frame) override {
+		gui.pushContainer(0, 0, ScreenWidth, ScreenHeight);
+		for (size_t i = 0; i < m_texts.size(); i++) {
+			const int col = int(i % 2), row = int(i / 2);
+			gui.pushLayout(col * 630, row * 26, 620, 24);
+				gui.edit(m_texts[i]);
+			gui.popLayout();
+		}
+		gui.popContainer();
+	}
+
+private:
+	std::vector<std::string> m_texts;
+};
+
+/// One focused edit box holding a long string, scrolled to its end
+class LongEditScenario : public Scenario {
+public:
+	inline LongEditScenario(size_t bytes) : m_name("edit_" + std::to_string(bytes)) {
+		const std::string words = "the quick brown fox jumps over the lazy dog ";
+		while (m_text.size() < bytes) m_text += words;
+		m_text.resize(bytes);
+	}
+
+	const char* name() const override { return m_name.c_str(); }
+	int widgets() const override { return 1; }
+
+	void script(ScriptedInput& input, int frame) override {
+		if (frame == 0) input.press(20, 14);
+		else if (frame == 1) input.release(20, 14);
+		else if (frame == 2) {
+			input.key(KeyEnd, true);
+			input.key(KeyEnd, false);
+		}
+	}
+
+	void build(Gui& gui, int frame) override {
+		gui.pushContainer(0, 0, ScreenWidth, ScreenHeight);
+			gui.pushLayout(0, 0, 620, 24);
+				gui.edit(m_text);
+			gui.popLayout();
+		gui.popContainer();
+	}
+
+private:
+	std::string m_name, m_text;
+};
+
+/// One focused edit box fed 1000 keystrokes a frame, every tenth a backspace
+class TypingScenario : public Scenario {
+public:
+	static constexpr int KeystrokesPerFrame = 1000;
+
+	const char* name() const override { return "typing"; }
+	int widgets() const override { return 1; }
+
+	void script(ScriptedInput& input, int frame) override {
+		m_scripted = true;
+		if (frame == 0) input.press(20, 14);
+		else if (frame == 1) input.release(20, 14);
+		else {
+			for (int i = 0; i < KeystrokesPerFrame; i++) {
+				if (i % 10 == 9) {
+					input.key(KeyBackspace, true);
+					input.key(KeyBackspace, false);
+					m_expected--;
+				} else {
+					input.type(char('a' + i % 26));
+					m_expected++;
+				}
+			}
+		}
+	}
+
+	void build(Gui& gui, int frame) override {
+		gui.pushContainer(0, 0, ScreenWidth, ScreenHeight);
+			gui.pushLayout(0, 0, 620, 24);
+				gui.edit(m_text);
+			gui.popLayout();
+		gui.popContainer();
+	}
+
+	const char* check(const NullRenderer& renderer, int frame) override {
+		// a replayed recording bypasses script(), there is nothing to check against
+		if (!m_scripted || m_text.size() == m_expected) return nullptr;
+		m_error = "keystrokes lost, " + std::to_string(m_text.size()) + " chars, expected " + std::to_string(m_expected);
+		return m_error.c_str();
+	}
+
+private:
+	std::string m_text, m_error;
+	size_t m_expected{ 0 };
+	bool m_scripted{ false };
+};
+
+/// A menu bar with one menu open over a long list
+class MenusScenario : public Scenario {
+public:
+	inline MenusScenario(int items) {
+		for (int i = 0; i < 12; i++) m_menuItems.push_back(i % 4 == 3 ? "-" : "Menu item " + std::to_string(i));
+		for (int i = 0; i < items; i++) m_listItems.push_back("List item " + std::to_string(i));
+	}
+
+	const char* name() const override { return "menus"; }
+	int widgets() const override { return 5; }
+
+	// Opens "Help", the last menu. A press counts as a click outside for every
+	// widget built after the pressed one, and those drop the new focus.
+	// Then hovers the next of its nine items every frame, the rows are 20
+	// pixels high from y 22 with a 3 pixel separator after every third one.
+	void script(ScriptedInput& input, int frame) override {
+		if (frame == 0) input.press(160, 10);
+		else if (frame == 1) input.release(160, 10);
+		else {
+			const int item = (frame - 2) % 9;
+			input.move(200, 32 + item * 20 + (item / 3) * 3);
+		}
+	}
+
+	void build(Gui& gui, int frame) override {
+		static const char* titles[] = { "File", "Edit", "View", "Help" };
+
+		// the list goes first, so the press on the menu bar is not taken as a click outside it
+		gui.pushContainer(0, 24, ScreenWidth, ScreenHeight - 24);
+			gui.pushLayout(0, 0, 400, 0, Dock::DockFill);
+				gui.list(&m_listSel, m_listItems);
+			gui.popLayout();
+		gui.popContainer();
+
+		gui.pushContainer(0, 0, ScreenWidth, 22);
+		for (int i = 0; i < 4; i++) {
+			gui.pushLayout(0, 0, gui.textWidth(titles[i]) + 16, 0, Dock::DockLeft, 0);
+				gui.menu(titles[i], &m_menuSel[i], m_menuItems);
+			gui.popLayout();
+		}
+		gui.popContainer();
+	}
+
+	const char* check(const NullRenderer& renderer, int frame) override {
+		// pressed on frame 0, open from the release on
+		if (frame < 2) return nullptr;
+		const std::vector<Command>& popup = renderer.layerCommands(LayerPopup);
+		if (popup.empty()) return "the menu did not open";
+
+		// the hovered item is the only filled rect of the popup
+		const bool hovered = std::any_of(popup.begin(), popup.end(), [](const Command& cmd) { return cmd.type == Command::CmdFillRect; });
+		return hovered ? nullptr : "no menu item is hovered";
+	}
+
+private:
+	std::vector<std::string> m_menuItems, m_listItems;
+	int m_menuSel[4]{ -1, -1, -1, -1 };
+	int m_listSel{ 0 };
+};
+
+/// Scroll containers nested in a scroll container, holding many buttons
+class ScrollScenario : public Scenario {
+public:
+	inline ScrollScenario(int groups, int buttonsPerGroup) : m_groups(groups), m_buttons(buttonsPerGroup) {
+		for (int i = 0; i < buttonsPerGroup; i++) m_labels.push_back("Item " + std::to_string(i));
+	}
+
+	const char* name() const override { return "scroll"; }
+	int widgets() const override { return m_groups * m_buttons; }
+
+	void script(ScriptedInput& input, int frame) override {
+		input.move((frame * 11) % 800, (frame * 5) % 680);
+	}
+
+	void build(Gui& gui, int frame) override {
+		const int groupHeight = 230;
+		gui.pushScrollContainer(16, 16, 800, 680, 1000, m_groups * groupHeight);
+		for (int g = 0; g < m_groups; g++) {
+			gui.pushID(1000 + g * (m_buttons + 8));
+			gui.pushScrollContainer(0, g * groupHeight, 600, 220, 600, m_buttons * 24);
+			for (int i = 0; i < m_buttons; i++) {
+				gui.pushLayout(0, i * 24, 200, 20);
+					gui.button(m_labels[i]);
+				gui.popLayout();
+			}
+			gui.popScrollContainer();
+			gui.popID();
+		}
+		gui.popScrollContainer();
+	}
+
+private:
+	int m_groups, m_buttons;
+	std::vector<std::string> m_labels;
+};
+
+/// About 10 KB of label text per frame, half wrapped and half cut with ellipses
+class TextScenario : public Scenario {
+public:
+	inline TextScenario(size_t bytes) {
+		static const char* words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do" };
+		size_t total = 0;
+		for (int i = 0; total < bytes; i++) {
+			std::string label = "Label " + std::to_string(i) + ":";
+			for (int w = 0; label.size() < 80; w++) {
+				label += (w % 9 == 8) ? '\n' : ' ';
+				label += words[(i + w * 3) % 10];
+			}
+			total += label.size();
+			m_labels.push_back(label);
+		}
+	}
+
+	const char* name() const override { return "text"; }
+	int widgets() const override { return int(m_labels.size()); }
+
+	void build(Gui& gui, int frame) override {
+		gui.pushContainer(0, 0, ScreenWidth, ScreenHeight);
+		int y = 0;
+		for (size_t i = 0; i < m_labels.size(); i++) {
+			const bool wrap = i % 2 == 0;
+			const int height = wrap ? gui.textHeight(m_labels[i]) * 2 : 16;
+			gui.pushLayout(0, y, 400, height);
+				gui.text(0, 0, m_labels[i], wrap ? Overflow::OverfowWrap : Overflow::OverfowEllipses);
+			gui.popLayout();
+			y += height + 2;
+		}
+		gui.popContainer();
+	}
+
+private:
+	std::vector<std::string> m_labels;
+};
+
+struct FrameSample {
+	double time;
+	int commands, culled;
+	size_t allocations, heapPeak;
+	FrameStats stats;
+	FrameStatus status;
+};
+
+struct Summary {
+	double mean, p50, p95, p99, max;
+};
+
+static Summary summarize(std::vector<double> values) {
+	Summary s{};
+	if (values.empty()) return s;
+	std::sort(values.begin(), values.end());
+	double sum = 0.0;
+	for (double v : values) sum += v;
+	auto pct = [&](double p) { return values[std::min(values.size() - 1, size_t(p * values.size()))]; };
+	s.mean = sum / values.size();
+	s.p50 = pct(0.50);
+	s.p95 = pct(0.95);
+	s.p99 = pct(0.99);
+	s.max = values.back();
+	return s;
+}
+
+static void writeSummary(FILE* out, const char* key, const Summary& s, bool last = false) {
+	std::fprintf(out, "      \"%s\": { \"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f }%s\n",
+		key, s.mean, s.p50, s.p95, s.p99, s.max, last ? "" : ",");
+}
+
+struct RunOptions {
+	int warmup, frames;
+	size_t textCache;
+	const char* recordPath;
+	const char* replayPath;
+};
+
+static std::vector<FrameSample> run(Scenario& scenario, const RunOptions& options, std::string& failure) {
+	ScriptedInput* script = nullptr;
+	InputManager* input = nullptr;
+	int frames = options.warmup + options.frames;
+	if (options.replayPath) {
+		InputReplayer* replay = new InputReplayer(options.replayPath);
+		frames = int(replay->frames());
+		input = replay;
+	} else {
+		script = new ScriptedInput();
+		input = options.recordPath ? (InputManager*) new InputRecorder(script, options.recordPath) : script;
+	}
+
+	NullRenderer* renderer = new NullRenderer();
+	Gui gui(input, renderer);
+	gui.textCache().setCapacity(options.textCache);
+
+	std::vector<FrameSample> samples;
+	samples.reserve(std::max(frames - options.warmup, 0));
+
+	HeapStats& heapStats = heap();
+	for (int frame = 0; frame < frames; frame++) {
+		const size_t allocsBefore = heapStats.allocations;
+		heapStats.peak = heapStats.live;
+
+		const auto start = Clock::now();
+		if (script) {
+			script->setTime(frame * 16);
+			scenario.script(*script, frame);
+		}
+		gui.prepare();
+		scenario.build(gui, frame);
+		if (failure.empty()) {
+			if (const char* error = scenario.check(*renderer, frame)) failure = "frame " + std::to_string(frame) + ": " + error;
+		}
+		const FrameStatus status = gui.finish(ScreenWidth, ScreenHeight);
+		const auto stop = Clock::now();
+
+		if (frame < options.warmup) continue;
+
+		FrameSample sample{};
+		sample.time = elapsedMicros(start, stop);
+		sample.commands = renderer->stats().commands;
+		sample.culled = renderer->stats().culledCommands;
+		sample.allocations = heapStats.allocations - allocsBefore;
+		sample.heapPeak = heapStats.peak;
+		sample.stats = gui.stats();
+		sample.status = status;
+		samples.push_back(sample);
+	}
+	return samples;
+}
+
+int main(int argc, char** argv) {
+	int frames = 2000, warmup = 20;
+	const char* only = nullptr;
+	const char* outPath = nullptr;
+	const char* tracePath = nullptr;
+	bool perFrame = false;
+	size_t textCache = SGUI_TEXT_CACHE_BYTES;
+	const char* recordPath = nullptr;
+	const char* replayPath = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) frames = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "--warmup") && i + 1 < argc) warmup = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "--scenario") && i + 1 < argc) only = argv[++i];
+		else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) outPath = argv[++i];
+		else if (!std::strcmp(argv[i], "--trace") && i + 1 < argc) tracePath = argv[++i];
+		else if (!std::strcmp(argv[i], "--text-cache") && i + 1 < argc) textCache = size_t(std::atoll(argv[++i]));
+		else if (!std::strcmp(argv[i], "--record") && i + 1 < argc) recordPath = argv[++i];
+		else if (!std::strcmp(argv[i], "--replay") && i + 1 < argc) replayPath = argv[++i];
+		else if (!std::strcmp(argv[i], "--per-frame")) perFrame = true;
+		else {
+			std::fprintf(stderr, "usage: %s [--frames N] [--warmup N] [--scenario NAME] [--text-cache BYTES] [--per-frame] [--out FILE] [--trace FILE] [--record FILE | --replay FILE]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if ((recordPath || replayPath) && !only) {
+		std::fprintf(stderr, "--record and --replay need --scenario\n");
+		return 1;
+	}
+	if (recordPath && replayPath) {
+		std::fprintf(stderr, "--record and --replay are exclusive\n");
+		return 1;
+	}
+	if (replayPath && !InputReplayer(replayPath).loaded()) {
+		std::fprintf(stderr, "%s is not an input recording\n", replayPath);
+		return 1;
+	}
+
+	std::vector<std::unique_ptr<Scenario>> scenarios;
+	scenarios.emplace_back(new ButtonsScenario(1000));
+	scenarios.emplace_back(new SlidersScenario(500));
+	scenarios.emplace_back(new EditsScenario(200));
+	scenarios.emplace_back(new LongEditScenario(100));
+	scenarios.emplace_back(new LongEditScenario(1 << 20));
+	scenarios.emplace_back(new TypingScenario());
+	scenarios.emplace_back(new MenusScenario(200));
+	scenarios.emplace_back(new ScrollScenario(50, 100));
+	scenarios.emplace_back(new TextScenario(10 * 1024));
+
+	FILE* out = outPath ? std::fopen(outPath, "w") : stdout;
+	if (out == nullptr) {
+		std::fprintf(stderr, "could not open %s\n", outPath);
+		return 1;
+	}
+
+	std::fprintf(out, "{\n  \"frames\": %d,\n  \"warmup\": %d,\n  \"text_cache_bytes\": %zu,\n  \"scenarios\": [\n", frames, warmup, textCache);
+	bool first = true, failed = false;
+	for (auto& scenario : scenarios) {
+		if (only && std::strcmp(only, scenario->name())) continue;
+
+		std::string failure;
+		const std::vector<FrameSample> samples = run(*scenario, RunOptions{ warmup, frames, textCache, recordPath, replayPath }, failure);
+		if (!failure.empty()) {
+			std::fprintf(stderr, "%s: %s\n", scenario->name(), failure.c_str());
+			failed = true;
+		}
+
+		std::vector<double> times, commands, culled, allocs;
+		std::vector<double> widgets, layouts, glyphs, cacheHits, cacheMisses, events, dropped, build, sort, translate, submit;
+		size_t totalAllocs = 0, heapPeak = 0;
+		int changedFrames = 0, idleFrames = 0;
+		for (const FrameSample& s : samples) {
+			times.push_back(s.time);
+			widgets.push_back(s.stats.widgets);
+			layouts.push_back(s.stats.layoutPushes);
+			glyphs.push_back(s.stats.glyphs);
+			cacheHits.push_back(s.stats.textCacheHits);
+			cacheMisses.push_back(s.stats.textCacheMisses);
+			events.push_back(s.stats.inputEvents);
+			dropped.push_back(s.stats.droppedInputEvents);
+			build.push_back(s.stats.buildTime);
+			sort.push_back(s.stats.sortTime);
+			translate.push_back(s.stats.translateTime);
+			submit.push_back(s.stats.submitTime);
+			commands.push_back(s.commands);
+			culled.push_back(s.culled);
+			allocs.push_back(double(s.allocations));
+			totalAllocs += s.allocations;
+			heapPeak = std::max(heapPeak, s.heapPeak);
+			if (s.status.changed) changedFrames++;
+			if (s.status.deadline < 0) idleFrames++;
+		}
+
+		std::fprintf(out, "%s    {\n", first ? "" : ",\n");
+		std::fprintf(out, "      \"name\": \"%s\",\n", scenario->name());
+		std::fprintf(out, "      \"widgets\": %d,\n", scenario->widgets());
+		std::fprintf(out, "      \"failed\": %s,\n", failure.empty() ? "false" : "true");
+		writeSummary(out, "frame_time_us", summarize(times));
+		writeSummary(out, "commands", summarize(commands));
+		writeSummary(out, "culled", summarize(culled));
+		writeSummary(out, "widgets_evaluated", summarize(widgets));
+		writeSummary(out, "layout_pushes", summarize(layouts));
+		writeSummary(out, "glyphs", summarize(glyphs));
+		writeSummary(out, "text_cache_hits", summarize(cacheHits));
+		writeSummary(out, "text_cache_misses", summarize(cacheMisses));
+		writeSummary(out, "input_events", summarize(events));
+		writeSummary(out, "dropped_input_events", summarize(dropped));
+		writeSummary(out, "build_time_us", summarize(build));
+		writeSummary(out, "sort_time_us", summarize(sort));
+		writeSummary(out, "translate_time_us", summarize(translate));
+		writeSummary(out, "submit_time_us", summarize(submit));
+		writeSummary(out, "allocations", summarize(allocs));
+		std::fprintf(out, "      \"allocations_total\": %zu,\n", totalAllocs);
+		std::fprintf(out, "      \"changed_frames\": %d,\n", changedFrames);
+		std::fprintf(out, "      \"idle_frames\": %d,\n", idleFrames);
+		std::fprintf(out, "      \"heap_peak_bytes\": %zu", heapPeak);
+		if (perFrame) {
+			std::fprintf(out, ",\n      \"per_frame\": [\n");
+			for (size_t i = 0; i < samples.size(); i++) {
+				const FrameSample& s = samples[i];
+				std::fprintf(out, "        { \"time_us\": %.3f, \"commands\": %d, \"culled\": %d, \"allocations\": %zu, \"heap_peak_bytes\": %zu }%s\n",
+					s.time, s.commands, s.culled, s.allocations, s.heapPeak, i + 1 < samples.size() ? "," : "");
+			}
+			std::fprintf(out, "      ]");
+		}
+		std::fprintf(out, "\n    }");
+		first = false;
+	}
+	std::fprintf(out, "\n  ],\n  \"max_rss_kb\": %ld\n}\n", maxResidentKB());
+
+	if (out != stdout) std::fclose(out);
+
+	if (tracePath) {
+#ifdef SGUI_PROFILING
+		if (!sgui::profile::saveChromeTrace(tracePath)) {
+			std::fprintf(stderr, "could not write %s\n", tracePath);
+			return 1;
+		}
+#else
+		std::fprintf(stderr, "--trace ignored, built without SGUI_PROFILING\n");
+#endif
+	}
+	return failed ? 1 : 0;
+}
@@ -2,6 +2,7 @@
 #include <map>
 #include <string>
 #include <algorithm>
+#include <cmath>
 #include <vector>
 #include <cstdarg>
 #include <sstream>
@@ -12,6 +13,7 @@
 
 #include "simple_gui_sdl2.hpp"
 #include "simple_gui_gl3.hpp"
+#include "simple_gui_record.hpp"
 using namespace sgui;
 
 int main(int argc, char** argv) {
@@ -32,15 +34,45 @@ int main(int argc, char** argv) {
 	// SDL_Renderer *ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED);
 	// if (ren == nullptr) return 1;
 
-	Gui gui(new SDLInput(), new GL3Renderer());
+	// The demo draws nothing but the GUI, so the renderer may keep its GL state bound
+	GL3Renderer* renderer = new GL3Renderer((GLADloadproc) SDL_GL_GetProcAddress);
+	renderer->setHostOwnsState(true);
+
+	// Later launches load the linked shaders instead of compiling them
+	if (char* pref = SDL_GetPrefPath("DCubix", "simple_gui")) {
+		renderer->setProgramCache(std::string(pref) + "gl3_program.bin");
+		SDL_free(pref);
+	}
+
+	// --record FILE keeps the session's input, for replaying it in sgui_bench
+	InputManager* input = new SDLInput();
+	if (argc > 2 && std::string(argv[1]) == "--record") input = new InputRecorder(input, argv[2]);
+
+	Gui gui(input, renderer);
+
+	const StartupStats& startup = gui.startupStats();
+	std::cout << "font upload " << startup.fontUploadTime
+			  << " us, shaders " << startup.shaderBuildTime << " us" << (startup.programCacheHit ? " (cached)" : "") << std::endl;
 
 	SDL_Event evt;
 	bool running = true;
+	FrameStatus status{};
+	int lastFrame = 0;
 	while (running) {
-		while (SDL_PollEvent(&evt)) {
-			if (evt.type == SDL_QUIT) running = false;
-			else gui.input()->processEvents(&evt);
+		// Sleep until input comes in or the GUI has a deadline, at most 60 frames a second
+		const int now = SDL_GetTicks();
+		int timeout = -1;
+		if (status.deadline >= 0) timeout = std::max({ 0, status.deadline - now, lastFrame + 1000 / 60 - now });
+
+		bool exposed = false;
+		if (SDL_WaitEventTimeout(&evt, timeout)) {
+			do {
+				if (evt.type == SDL_QUIT) running = false;
+				else if (evt.type == SDL_WINDOWEVENT) exposed = true;
+				else gui.input()->processEvents(&evt);
+			} while (SDL_PollEvent(&evt));
 		}
+		lastFrame = SDL_GetTicks();
 
 		int w, h;
 		SDL_GetWindowSize(win, &w, &h);
@@ -54,10 +86,10 @@ int main(int argc, char** argv) {
 		abg.g = lerp(abg.g, bg.g, 0.1f);
 		abg.b = lerp(abg.b, bg.b, 0.1f);
 
-		glClearColor(abg.r, abg.g, abg.b, abg.a);
-		glClear(GL_COLOR_BUFFER_BIT);
-		// SDL_SetRenderDrawColor(ren, abg[0], abg[1], abg[2], 255);
-		// SDL_RenderClear(ren);
+		// The background is not drawn by the GUI, keep frames coming while it fades
+		const bool fading = std::abs(abg.r - bg.r) + std::abs(abg.g - bg.g) + std::abs(abg.b - bg.b) > 1.0f / 255.0f;
+		if (fading) gui.requestRedraw(lastFrame + 1000 / 60);
+		else abg = bg;
 
 		gui.pushContainer(0, 0, w, 22);
 			static int fileSel = -1;
@@ -85,11 +117,36 @@ int main(int argc, char** argv) {
 			gui.popLayout();
 		gui.popScrollContainer();
 
-		gui.finish(w, h);
+		// Counters of the last drawn frame. They only refresh on input, a line
+		// that changed with them would keep causing frames of its own.
+		static FrameStats drawn{};
+		static std::string counters;
+		if (counters.empty() || gui.input()->eventCount() > 0) {
+			counters =
+				"draw calls: " + std::to_string(drawn.drawCalls) +
+				"  batches: " + std::to_string(drawn.batches) +
+				"  gl calls: " + std::to_string(drawn.glCalls) +
+				" (" + std::to_string(drawn.glCallsSkipped) + " skipped)";
+		}
+		gui.pushContainer(0, h - 20, w, 20);
+			gui.text(0, 0, counters);
+		gui.popContainer();
 
-		SDL_GL_SwapWindow(win);
-		// SDL_RenderPresent(ren);
-		SDL_Delay(1000 / 60);
+		// Nothing new to show, the front buffer already has this frame
+		const bool redraw = fading || exposed;
+		if (redraw || gui.frameChanged()) {
+			glClearColor(abg.r, abg.g, abg.b, abg.a);
+			glClear(GL_COLOR_BUFFER_BIT);
+			// SDL_SetRenderDrawColor(ren, abg[0], abg[1], abg[2], 255);
+			// SDL_RenderClear(ren);
+		}
+
+		status = gui.finish(w, h, redraw);
+		if (status.changed || redraw) {
+			drawn = gui.stats();
+			SDL_GL_SwapWindow(win);
+			// SDL_RenderPresent(ren);
+		}
 	}
 
 	SDL_GL_DeleteContext(ctx);
@@ -4,7 +4,8 @@
 #pragma region EMBEDDED_FONT
 constexpr int fontWidth = 768;
 constexpr int fontHeight = 16;
-static const char* font_data =
+// Decoded at compile time into sgui::fontAtlas
+static constexpr char font_data[] =
 	"!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!"
 	"!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!"
 	"!!!!!!!!!!!!````````!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!"
@@ -777,23 +778,81 @@ static const char* font_data =
 #pragma endregion
 
 #include <iostream>
+#include <chrono>
+#include <climits>
 #include <map>
+#include <list>
+#include <unordered_map>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <vector>
 #include <array>
+#include <atomic>
 #include <stack>
 #include <cstdarg>
+#include <cstring>
 #include <sstream>
 #include <memory>
 #include <tuple>
+#include <type_traits>
+
+#include "simple_gui_profile.hpp"
 
 #define SGUI_RENDERER_PRIORITY_HIGHEST 0xFFFF
 #define SGUI_NO_SELECTION (INT_MIN)
 
+#ifndef SGUI_INPUT_QUEUE_SIZE
+#define SGUI_INPUT_QUEUE_SIZE 4096
+#endif
+
+#ifndef SGUI_TEXT_CACHE_BYTES
+#define SGUI_TEXT_CACHE_BYTES (256 * 1024)
+#endif
+
 namespace sgui {
 	using byte = unsigned char;
 
+	/**
+	 * The embedded font as 1 bit per pixel rows of pitch bytes, most
+	 * significant bit first.
+	 */
+	struct FontAtlas {
+		static constexpr int pitch = (fontWidth + 7) / 8;
+		byte bits[fontHeight * pitch]{};
+
+		constexpr bool pixel(int x, int y) const { return bits[y * pitch + x / 8] & (0x80 >> (x % 8)); }
+	};
+
+	constexpr FontAtlas decodeFontAtlas() {
+		FontAtlas atlas{};
+		int ptr = 0;
+		for (int y = 0; y < fontHeight; y++) {
+			for (int x = 0; x < fontWidth; x++) {
+				const byte pix = byte(((font_data[ptr + 0] - 33) << 2) | ((font_data[ptr + 1] - 33) >> 4));
+				ptr += 4;
+				if (pix > 120) {
+					byte& b = atlas.bits[y * FontAtlas::pitch + x / 8];
+					b = byte(b | (0x80 >> (x % 8)));
+				}
+			}
+		}
+		return atlas;
+	}
+
+	constexpr FontAtlas fontAtlas = decodeFontAtlas();
+
+	/// Atlas cell of a character, control characters map to the blank cell 0
+	constexpr int fontGlyph(char c) {
+		const int code = c & 0x7F;
+		return code < ' ' ? 0 : code - ' ';
+	}
+
+	/// Packed RGBA8 color, stored in memory as r, g, b, a.
+	struct Color32 {
+		byte r{ 0 }, g{ 0 }, b{ 0 }, a{ 255 };
+	};
+
 	struct Color {
 		float r{ 0.0f }, g{ 0.0f }, b{ 0.0f }, a{ 1.0f };
 
@@ -853,6 +912,15 @@ namespace sgui {
 					((*this)[2] & 0xFF) << 8 |
 					((*this)[3] & 0xFF);
 		}
+
+		inline Color32 rgba8() const {
+			return Color32{
+				byte((*this)[0] & 0xFF),
+				byte((*this)[1] & 0xFF),
+				byte((*this)[2] & 0xFF),
+				byte((*this)[3] & 0xFF)
+			};
+		}
 	};
 
 	struct Point {
@@ -985,38 +1053,146 @@ namespace sgui {
 		Rect parent, intersection;
 	};
 
-	class Renderer {
-	public:
-		struct Command {
-			enum {
-				CmdDummy = 0,
-				CmdDrawLine,
-				CmdDrawRect,
-				CmdFillRect,
-				CmdDrawImage,
-				CmdSetClip,
-				CmdUnsetClip
-			} type{ CmdDummy };
+	/**
+	 * Draw commands are plain data so they can be recorded into a
+	 * reusable buffer without touching the heap.
+	 * Images are referenced by a per-frame handle, use imageOf() to
+	 * get the pointer passed to image() back.
+	 */
+	struct Command {
+		enum Type : byte {
+			CmdDummy = 0,
+			CmdDrawLine,
+			CmdDrawRect,
+			CmdFillRect,
+			CmdDrawImage,
+			CmdDrawBox,
+			CmdDrawText,
+			CmdSetClip,
+			CmdUnsetClip,
+			CmdCount
+		};
 
-			std::vector<Point> points;
+		struct SourceRect { short x, y, w, h; };
 
-			Color color;
+		/// Extra style of a CmdDrawBox, the shadow is black and offset on both axes
+		struct BoxStyle {
+			byte border[4];			// RGBA8, plain bytes to keep the union trivial
+			byte borderWidth;
+			signed char shadowOffset;
+			byte shadowAlpha;
+			byte reserved;
 
-			void* image{ nullptr };
-			Rect src;
+			inline Color32 borderColor() const { return Color32{ border[0], border[1], border[2], border[3] }; }
+		};
 
-			int priority;
+		/// Characters of a CmdDrawText in the renderer's text arena, see Renderer::textOf()
+		struct TextRun {
+			unsigned int offset;
+			unsigned short length;
+			byte shadow;			// black copy one pixel below the glyphs
+			byte reserved;
 		};
 
+		Point points[2];
+		int z{ 0 };
+		Color32 color{};
+		union {
+			SourceRect src{ 0, 0, 0, 0 };	// CmdDrawImage
+			BoxStyle box;					// CmdDrawBox
+			TextRun run;					// CmdDrawText
+		};
+		unsigned short image{ 0 };
+		Type type{ CmdDummy };
+		byte flags{ 0 };
+	};
+
+	/**
+	 * Per-frame counters, see Gui::stats().
+	 * Times are in microseconds, measured with a steady high-resolution clock.
+	 */
+	struct FrameStats {
+		// Recording
+		std::array<int, Command::CmdCount> commandsByType{};
+		int commands{ 0 };			// commands recorded, clip changes included
+		int culledCommands{ 0 };	// draws dropped for lying outside the clip
+		int elidedClips{ 0 };		// clip changes that never reached the backend
+		int glyphs{ 0 };			// glyphs recorded in text runs, culled ones excluded
+
+		// Gui
+		int widgets{ 0 };
+		int layoutPushes{ 0 };
+		int textCacheHits{ 0 };		// text() calls replayed from the layout cache
+		int textCacheMisses{ 0 };	// text() calls laid out from scratch
+		int inputEvents{ 0 };		// events queued by the input backend for this frame
+		int droppedInputEvents{ 0 };	// events lost to a full input queue
+
+		// Backend
+		int batches{ 0 };
+		int drawCalls{ 0 };
+		size_t vertices{ 0 };
+		size_t instances{ 0 };		// primitives expanded to quads on the GPU
+		size_t uploadBytes{ 0 };
+		int uploadStalls{ 0 };		// uploads that had to wait for the GPU
+		int glCalls{ 0 };			// state changes, uploads and draws issued to the API
+		int glCallsSkipped{ 0 };	// state changes dropped as redundant
+
+		// Phases
+		double buildTime{ 0.0 };		// prepare() to finish()
+		double sortTime{ 0.0 };			// z sorting of the layers
+		double translateTime{ 0.0 };	// processCommands()
+		double submitTime{ 0.0 };		// end()
+	};
+
+	/**
+	 * One-off costs of creating a Gui, see Gui::startupStats().
+	 * Times are in microseconds.
+	 */
+	struct StartupStats {
+		double fontUploadTime{ 0.0 };	// Renderer::loadFont()
+		double createTime{ 0.0 };		// Renderer::created()
+		double shaderBuildTime{ 0.0 };	// shader compilation or program cache load, part of createTime
+		bool programCacheHit{ false };	// the program came from the backend's binary cache
+	};
+
+	using StatsClock = std::chrono::steady_clock;
+
+	inline double elapsedMicros(StatsClock::time_point start, StatsClock::time_point stop) {
+		return std::chrono::duration<double, std::micro>(stop - start).count();
+	}
+
+	/// Division rounding towards negative infinity, b > 0
+	constexpr int floorDiv(int a, int b) {
+		return a / b - (a % b < 0 ? 1 : 0);
+	}
+
+	/**
+	 * Draw layers, rendered in this order. Each layer has its own command
+	 * buffer so overlays never need a sort to end up on top.
+	 */
+	enum Layer {
+		LayerBase = 0,
+		LayerPopup,
+		LayerTooltip,
+		LayerDebug,
+		LayerCount
+	};
+
+	class Renderer {
+		friend class Gui;
+	public:
+		using Command = sgui::Command;
+
 		/**
 		 * @brief  Loads the default bitmap font into the GUI
 		 * @note   See the SDL2 implementation for an exampe
-		 * @param  pixels: Image pixels in RGBA form
+		 * @param  bits: 1 bit per pixel, rows of FontAtlas::pitch bytes, most significant
+		 * 		   bit first. Set pixels are opaque white.
 		 * @param  width: Image width
 		 * @param  height: Image height
 		 * @retval A pointer to a structure representing your texture handle
 		 */
-		virtual void* loadFont(const std::vector<byte>& pixels, int width, int height) = 0;
+		virtual void* loadFont(const byte* bits, int width, int height) = 0;
 
 		/**
 		 * @brief  Use this function for rendering API initialization
@@ -1040,6 +1216,17 @@ namespace sgui {
 		 */
 		virtual void processCommand(const Command& cmd) = 0;
 
+		/**
+		 * @brief  Processes a contiguous run of draw commands, in order
+		 * @note   Defaults to calling processCommand for each one
+		 * @param  cmds: Pointer to the first command
+		 * @param  count: Number of commands
+		 * @retval None
+		 */
+		virtual void processCommands(const Command* cmds, size_t count) {
+			for (size_t i = 0; i < count; i++) processCommand(cmds[i]);
+		}
+
 		/**
 		 * @brief  Called before the rendering API performs the rendering
 		 * @note   
@@ -1054,81 +1241,249 @@ namespace sgui {
 		 */
 		virtual void end(int width, int height) {}
 
-		inline void finish(int width, int height) {
-			std::sort(m_commands.begin(), m_commands.end(), [](const Command& a, const Command& b) {
-				return a.priority < b.priority;
-			});
+		/**
+		 * @brief  Sorts and submits the recorded commands, then starts over
+		 * @param  width: Viewport width
+		 * @param  height: Viewport height
+		 * @param  submit: False drops the commands without drawing them, for a
+		 * 		   frame that looks like the one already on screen
+		 * @retval None
+		 */
+		inline void finish(int width, int height, bool submit = true) {
+			SGUI_PROFILE_SCOPE("Renderer::finish");
+			for (auto& layer : m_layers) {
+				if (!submit || layer.commands.empty()) continue;
+				if (!layer.sorted) {
+					const auto start = StatsClock::now();
+					sortLayer(layer);
+					m_stats.sortTime += elapsedMicros(start, StatsClock::now());
+				}
+
+				// the first command of a layer always sets or unsets the clip,
+				// see CommandLayer::clipStale
+				const auto start = StatsClock::now();
+				processCommands(layer.commands.data(), layer.commands.size());
+				m_stats.translateTime += elapsedMicros(start, StatsClock::now());
+			}
 
-			while (!m_commands.empty()) {
-				Command cmd = m_commands.front();
-				m_commands.erase(m_commands.begin());
-				processCommand(cmd);
+			if (submit) {
+				const auto start = StatsClock::now();
+				end(width, height);
+				m_stats.submitTime = elapsedMicros(start, StatsClock::now());
 			}
-			end(width, height);
+
+			for (auto& layer : m_layers) {
+				layer.commands.clear();
+				layer.sorted = true;
+				layer.clipped = false;
+				layer.clipStale = true;
+			}
+			m_layer = LayerBase;
+			m_layerStack.clear();
+			m_clipStack.clear();
+			m_clipBase = 0;
+
+			m_frameStats = m_stats;
+			m_stats = FrameStats{};
 			m_z = 0;
 			m_zIndices.clear();
+			m_images.clear();
+			m_textArena.clear();
+			m_lastImage = 0;
 		}
 
 		inline void line(int x1, int y1, int x2, int y2, Color color) {
-			Command cmd{};
-			cmd.priority = m_z++;
-			cmd.type = Command::CmdDrawLine;
-			cmd.color = color;
-			cmd.points.push_back(Point(x1, y1));
-			cmd.points.push_back(Point(x2, y2));
-			m_commands.push_back(cmd);
+			if (culled(std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2))) return;
+
+			Command& cmd = pushDraw(Command::CmdDrawLine, color);
+			cmd.points[0] = Point(x1, y1);
+			cmd.points[1] = Point(x2, y2);
 		}
 
 		inline void rect(Rect rect, Color color, bool fill = false) {
-			Command cmd{};
-			cmd.priority = m_z++;
-			cmd.type = fill ? Command::CmdFillRect : Command::CmdDrawRect;
-			cmd.color = color;
-			cmd.points.push_back(Point(rect.x, rect.y));
-			cmd.points.push_back(Point(rect.x + rect.w, rect.y + rect.h));
-			m_commands.push_back(cmd);
+			if (culled(rect.x, rect.y, rect.x + rect.w, rect.y + rect.h)) return;
+
+			Command& cmd = pushDraw(fill ? Command::CmdFillRect : Command::CmdDrawRect, color);
+			cmd.points[0] = Point(rect.x, rect.y);
+			cmd.points[1] = Point(rect.x + rect.w, rect.y + rect.h);
+		}
+
+		/**
+		 * @brief  Draws a filled box with a border and a drop shadow as one command
+		 * @note   Backends may draw it in a single pass, so translucent parts do
+		 * 		   not blend over each other: the border is not drawn over the fill
+		 * 		   and the shadow only shows outside the box
+		 * @param  rect: Box area
+		 * @param  fill: Fill color, transparent for an outline only box
+		 * @param  border: Border color
+		 * @param  borderWidth: Border width in pixels, 0 for none
+		 * @param  shadowOffset: Shadow offset along both axes, 0 for none
+		 * @param  shadowAlpha: Opacity of the shadow
+		 * @retval None
+		 */
+		inline void box(Rect rect, Color fill, Color border, int borderWidth = 1, int shadowOffset = 0, float shadowAlpha = 0.45f) {
+			const int sx1 = std::min(rect.x, rect.x + shadowOffset), sy1 = std::min(rect.y, rect.y + shadowOffset);
+			const int sx2 = std::max(rect.x, rect.x + shadowOffset) + rect.w, sy2 = std::max(rect.y, rect.y + shadowOffset) + rect.h;
+			if (culled(sx1, sy1, sx2, sy2)) return;
+
+			Command& cmd = pushDraw(Command::CmdDrawBox, fill);
+			const Color32 bc = border.rgba8();
+			cmd.box = Command::BoxStyle{
+				{ bc.r, bc.g, bc.b, bc.a },
+				byte(std::min(std::max(borderWidth, 0), 255)),
+				(signed char)(std::min(std::max(shadowOffset, -128), 127)),
+				byte(std::min(std::max(shadowAlpha, 0.0f), 1.0f) * 255.0f + 0.5f),
+				0
+			};
+			cmd.points[0] = Point(rect.x, rect.y);
+			cmd.points[1] = Point(rect.x + rect.w, rect.y + rect.h);
 		}
 
 		inline void image(void* image, Rect src, Rect dst, Color color) {
-			Command cmd{};
-			cmd.priority = m_z++;
-			cmd.type = Command::CmdDrawImage;
-			cmd.color = color;
-			cmd.image = image;
-			cmd.src = src;
-			cmd.points.push_back(Point(dst.x, dst.y));
-			cmd.points.push_back(Point(dst.x + dst.w, dst.y + dst.h));
-			m_commands.push_back(cmd);
+			if (culled(dst.x, dst.y, dst.x + dst.w, dst.y + dst.h)) return;
+
+			Command& cmd = pushDraw(Command::CmdDrawImage, color);
+			cmd.image = imageHandle(image);
+			cmd.src = Command::SourceRect{ short(src.x), short(src.y), short(src.w), short(src.h) };
+			cmd.points[0] = Point(dst.x, dst.y);
+			cmd.points[1] = Point(dst.x + dst.w, dst.y + dst.h);
+		}
+
+		/**
+		 * @brief  Draws a run of glyphs of the embedded font, one 8x16 cell per char
+		 * @note   The characters are copied, they only need to live until the call returns
+		 * @param  font: The font handle returned by loadFont()
+		 * @param  x, y: Top left corner of the first glyph
+		 * @param  str: Characters, mapped to cells with fontGlyph()
+		 * @param  length: Number of characters
+		 * @param  color: Glyph color
+		 * @param  shadow: Also draw the glyphs in black, one pixel below
+		 * @retval None
+		 */
+		inline void text(void* font, int x, int y, const char* str, size_t length, Color color, bool shadow = true) {
+			if (clipped() && length > 0) {
+				// drop the glyphs left and right of the clip, keeping one either side for the inclusive edges
+				const Rect& c = m_clipStack.back();
+				const long first = std::max(0, floorDiv(c.x - 1 - x, 8));
+				const long last = std::min<long>(long(length), long(floorDiv(c.x + c.w - x, 8)) + 1);
+				if (first >= last) {
+					m_stats.culledCommands++;
+					return;
+				}
+				str += first;
+				x += int(first) * 8;
+				length = size_t(last - first);
+			}
+
+			if (length == 0 || culled(x, y, x + int(length) * 8, y + 16 + (shadow ? 1 : 0))) return;
+
+			// a command holds at most USHRT_MAX glyphs, longer runs take several
+			const unsigned short image = imageHandle(font);
+			while (length > 0) {
+				const size_t count = std::min<size_t>(length, USHRT_MAX);
+				Command& cmd = pushDraw(Command::CmdDrawText, color);
+				cmd.image = image;
+				cmd.run = Command::TextRun{ unsigned(m_textArena.size()), (unsigned short) count, byte(shadow ? 1 : 0), 0 };
+				cmd.points[0] = Point(x, y);
+				cmd.points[1] = Point(x + int(count) * 8, y + 16);
+				m_textArena.insert(m_textArena.end(), str, str + count);
+				m_stats.glyphs += int(count);
+				str += count;
+				x += int(count) * 8;
+				length -= count;
+			}
+		}
+
+		/**
+		 * @brief  Hash of everything recorded so far this frame
+		 * @note   Equal hashes mean the frame draws the same as the one it
+		 * 		   was compared with, barring collisions
+		 * @retval The hash
+		 */
+		inline uint64_t commandHash() const {
+			uint64_t h = 0x9E3779B97F4A7C15ull;
+			for (const auto& layer : m_layers) {
+				h = hashBytes(layer.commands.data(), layer.commands.size() * sizeof(Command), h);
+			}
+			h = hashBytes(m_images.data(), m_images.size() * sizeof(void*), h);
+			return hashBytes(m_textArena.data(), m_textArena.size(), h);
+		}
+
+		/**
+		 * @brief  Commands recorded on a layer so far this frame
+		 * @param  layer: The layer
+		 * @retval The commands, in recording order until the frame is sorted
+		 */
+		inline const std::vector<Command>& layerCommands(Layer layer) const { return m_layers[layer].commands; }
+
+		/**
+		 * @brief  Resolves the characters of a text run
+		 * @param  cmd: A CmdDrawText command
+		 * @retval The characters, valid until the end of the frame
+		 */
+		inline std::string_view textOf(const Command& cmd) const {
+			return std::string_view(m_textArena.data() + cmd.run.offset, cmd.run.length);
+		}
+
+		/**
+		 * @brief  Resolves the image handle stored in a command
+		 * @param  cmd: A CmdDrawImage or CmdDrawText command
+		 * @retval The image pointer that was passed to image()
+		 */
+		inline void* imageOf(const Command& cmd) const {
+			return cmd.image == 0 ? nullptr : m_images[cmd.image - 1];
 		}
 
-		inline void setClipRect(Rect rect) {
-			Command cmd{};
-			cmd.priority = m_z++;
-			cmd.type = Command::CmdSetClip;
-			cmd.points.push_back(Point(rect.x, rect.y));
-			cmd.points.push_back(Point(rect.x + rect.w, rect.y + rect.h));
-			m_commands.push_back(cmd);
+		/**
+		 * @brief  Sends the following commands to another layer
+		 * @param  layer: The target layer
+		 * @retval None
+		 */
+		inline void pushLayer(Layer layer) {
+			m_layerStack.push_back(LayerState{ m_layer, m_z, m_clipBase });
+			m_layer = layer;
+			m_z = 0;
+			m_clipBase = m_clipStack.size();
+			m_layers[m_layer].clipStale = true;
 		}
 
-		inline void unsetClipRect() {
-			Command cmd{};
-			cmd.priority = m_z++;
-			cmd.type = Command::CmdUnsetClip;
-			m_commands.push_back(cmd);
+		inline void popLayer() {
+			if (!m_layerStack.empty()) {
+				m_clipStack.resize(m_clipBase);
+				m_layer = m_layerStack.back().layer;
+				m_z = m_layerStack.back().z;
+				m_clipBase = m_layerStack.back().clipBase;
+				m_layerStack.pop_back();
+				m_layers[m_layer].clipStale = true;
+			}
 		}
 
+		/**
+		 * @brief  Sets the z key of the following commands within the current layer
+		 * @note   Commands with equal z keep their recording order
+		 * @param  index: The z key
+		 * @retval None
+		 */
 		inline void pushZIndex(int index) {
 			m_zIndices.push_back(m_z);
+			if (index != m_z) m_layers[m_layer].clipStale = true;
 			m_z = index;
 		}
 
 		inline void popZIndex() {
 			if (!m_zIndices.empty()) {
+				if (m_zIndices.back() != m_z) m_layers[m_layer].clipStale = true;
 				m_z = m_zIndices.back();
 				m_zIndices.pop_back();
 			}
 		}
 
+		/**
+		 * @brief  Pushes a clip rectangle, intersected with the current one
+		 * @note   Draws that fall completely outside of it are dropped right away
+		 * @param  rect: The clip rectangle
+		 * @retval None
+		 */
 		inline void clip(Rect rect) {
 			if (rect.w < 0) {
 				rect.w = -rect.w;
@@ -1138,18 +1493,216 @@ namespace sgui {
 				rect.h = -rect.h;
 				rect.y -= rect.h;
 			}
-			setClipRect(rect);
+			if (clipped()) {
+				rect = rect.intersection(m_clipStack.back());
+				rect.w = std::max(rect.w, 0);
+				rect.h = std::max(rect.h, 0);
+			}
+			m_clipStack.push_back(rect);
+			// counted as elided until a draw actually needs it
+			m_stats.elidedClips++;
 		}
 
+		/**
+		 * @brief  Pops the last clip rectangle, restoring the previous one
+		 * @retval None
+		 */
 		inline void unclip() {
-			unsetClipRect();
+			if (clipped()) {
+				m_clipStack.pop_back();
+				m_stats.elidedClips++;
+			}
+		}
+
+		/**
+		 * @brief  Drops every clip rectangle of the current layer
+		 * @retval None
+		 */
+		inline void resetClip() {
+			while (clipped()) unclip();
 		}
+
+		inline bool clipped() const { return m_clipStack.size() > m_clipBase; }
+
+		/**
+		 * @brief  The current clip rectangle
+		 * @retval The rectangle, or nullptr when nothing is clipped
+		 */
+		inline const Rect* clipRect() const { return clipped() ? &m_clipStack.back() : nullptr; }
+
+		/**
+		 * @brief  Counters of the last finished frame
+		 * @retval The frame stats
+		 */
+		inline const FrameStats& stats() const { return m_frameStats; }
+
+		/**
+		 * @brief  Costs of loading the font and creating the backend
+		 * @retval The startup stats
+		 */
+		inline const StartupStats& startupStats() const { return m_startupStats; }
+
+	protected:
+		FrameStats m_stats{};
+		StartupStats m_startupStats{};
+
 	private:
-		std::vector<Command> m_commands;
+		struct CommandLayer {
+			std::vector<Command> commands;
+			Rect clip{};
+			bool sorted{ true }, clipped{ false };
+			// sorting moves the draws of each z away from the clip commands
+			// recorded at another, so a new z starts with its own clip command
+			bool clipStale{ true };
+		};
+
+		struct LayerState {
+			Layer layer;
+			int z;
+			size_t clipBase;
+		};
+
+		std::array<CommandLayer, LayerCount> m_layers;
+		std::vector<Command> m_scratch;
+		std::vector<LayerState> m_layerStack;
+		std::vector<Rect> m_clipStack;
+		size_t m_clipBase{ 0 };
+		FrameStats m_frameStats{};
 		std::vector<int> m_zIndices;
+		std::vector<void*> m_images;
+		std::vector<char> m_textArena;
+		Layer m_layer{ LayerBase };
 		int m_z{ 0 };
+		unsigned short m_lastImage{ 0 };
+
+		inline Command& push(Command::Type type, Color color) {
+			CommandLayer& layer = m_layers[m_layer];
+			if (!layer.commands.empty() && m_z < layer.commands.back().z) layer.sorted = false;
+
+			layer.commands.emplace_back();
+			Command& cmd = layer.commands.back();
+			cmd.type = type;
+			cmd.z = m_z;
+			cmd.color = color.rgba8();
+			m_stats.commands++;
+			m_stats.commandsByType[type]++;
+			return cmd;
+		}
+
+		/// Records a draw, emitting the clip command it needs first if the
+		/// layer's clip state is stale. Redundant clip changes never get recorded,
+		/// a clip repeated for a new z is not counted as a change.
+		inline Command& pushDraw(Command::Type type, Color color) {
+			CommandLayer& layer = m_layers[m_layer];
+			const bool stale = layer.clipStale;
+			layer.clipStale = false;
+			if (!clipped()) {
+				if (layer.clipped || stale) {
+					push(Command::CmdUnsetClip, Color());
+					if (layer.clipped) m_stats.elidedClips--;
+					layer.clipped = false;
+				}
+			} else {
+				const bool changed = !layer.clipped || layer.clip != m_clipStack.back();
+				if (changed || stale) {
+					const Rect& rect = m_clipStack.back();
+					Command& cmd = push(Command::CmdSetClip, Color());
+					cmd.points[0] = Point(rect.x, rect.y);
+					cmd.points[1] = Point(rect.x + rect.w, rect.y + rect.h);
+					layer.clip = rect;
+					layer.clipped = true;
+					if (changed) m_stats.elidedClips--;
+				}
+			}
+			return push(type, color);
+		}
+
+		/// Checks the bounds of a draw against the current clip rectangle.
+		/// Edges are inclusive, outlines touch x + w.
+		inline bool culled(int x1, int y1, int x2, int y2) {
+			if (!clipped()) return false;
+
+			const Rect& c = m_clipStack.back();
+			if (c.w <= 0 || c.h <= 0 ||
+				x2 < c.x - 1 || x1 > c.x + c.w ||
+				y2 < c.y - 1 || y1 > c.y + c.h
+			) {
+				m_stats.culledCommands++;
+				return true;
+			}
+			return false;
+		}
+
+		/// Stable LSD radix sort on the z key, skipping bytes all keys share.
+		inline void sortLayer(CommandLayer& layer) {
+			std::vector<Command>& cmds = layer.commands;
+			const size_t n = cmds.size();
+			m_scratch.resize(n);
+
+			Command* src = cmds.data();
+			Command* dst = m_scratch.data();
+			bool swapped = false;
+			for (int shift = 0; shift < 32; shift += 8) {
+				size_t offsets[256] = { 0 };
+				for (size_t i = 0; i < n; i++) offsets[radixDigit(src[i], shift)]++;
+				if (offsets[radixDigit(src[0], shift)] == n) continue;
+
+				size_t sum = 0;
+				for (size_t& off : offsets) {
+					const size_t count = off;
+					off = sum;
+					sum += count;
+				}
+				for (size_t i = 0; i < n; i++) dst[offsets[radixDigit(src[i], shift)]++] = src[i];
+
+				std::swap(src, dst);
+				swapped = !swapped;
+			}
+
+			if (swapped) cmds.swap(m_scratch);
+			layer.sorted = true;
+		}
+
+		/// Eight bytes at a time, the length is mixed in so empty layers still count
+		static inline uint64_t hashBytes(const void* data, size_t size, uint64_t h) {
+			const byte* bytes = (const byte*) data;
+			auto mix = [&h](uint64_t w) {
+				h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+				h ^= h >> 32;
+			};
+			size_t i = 0;
+			for (; i + 8 <= size; i += 8) {
+				uint64_t w;
+				std::memcpy(&w, bytes + i, 8);
+				mix(w);
+			}
+			uint64_t tail = 0;
+			if (i < size) std::memcpy(&tail, bytes + i, size - i);
+			mix(tail);
+			mix(size);
+			return h;
+		}
+
+		static inline size_t radixDigit(const Command& cmd, int shift) {
+			// flip the sign bit so negative keys sort first
+			return ((unsigned int)(cmd.z) ^ 0x80000000u) >> shift & 0xFF;
+		}
+
+		inline unsigned short imageHandle(void* image) {
+			if (image == nullptr) return 0;
+			if (m_lastImage != 0 && m_images[m_lastImage - 1] == image) return m_lastImage;
+			for (size_t i = 0; i < m_images.size(); i++) {
+				if (m_images[i] == image) return m_lastImage = (unsigned short)(i + 1);
+			}
+			m_images.push_back(image);
+			return m_lastImage = (unsigned short)(m_images.size());
+		}
 	};
 
+	static_assert(std::is_trivially_copyable<Renderer::Command>::value, "Renderer::Command must stay plain data");
+	static_assert(sizeof(Renderer::Command) <= 40, "Renderer::Command grew past its budget");
+	static_assert(std::has_unique_object_representations<Renderer::Command>::value, "Renderer::commandHash() hashes commands as bytes, they must not have padding");
+
 	enum Key {
 		KeyCtrl = 0,
 		KeyShift,
@@ -1167,12 +1720,37 @@ namespace sgui {
 		KeyCount
 	};
 
+	/**
+	 * One input event, as queued by the backend between two frames.
+	 */
+	struct InputEvent {
+		enum Type : byte {
+			EventMouseMove = 0,
+			EventMouseDown,
+			EventMouseUp,
+			EventKeyDown,
+			EventKeyUp,
+			EventText
+		};
+
+		Type type{ EventMouseMove };
+		Key key{ KeyCount };	// EventKeyDown, EventKeyUp
+		byte length{ 0 };		// EventText, bytes used in text
+		char text[4]{};			// EventText, one UTF-8 encoded code point
+		int button{ 0 };		// EventMouseDown, EventMouseUp
+		int x{ 0 }, y{ 0 };		// mouse position, mouse events
+		int time{ 0 };			// milliseconds, the backend's clock
+	};
+
 	class InputManager {
 		friend class Gui;
 	public:
-		struct State {
-			bool pressed{ false }, released{ false }, down{ false };
-		};
+		/// Mouse buttons 0 to MouseButtonCount - 1 are tracked, others are ignored
+		static constexpr int MouseButtonCount = 32;
+		static constexpr size_t QueueSize = SGUI_INPUT_QUEUE_SIZE;
+		static_assert((QueueSize & (QueueSize - 1)) == 0, "SGUI_INPUT_QUEUE_SIZE must be a power of two");
+
+		virtual ~InputManager() = default;
 
 		virtual void init(std::array<int, KeyCount>& keymap) = 0;
 		virtual int time() = 0;
@@ -1180,46 +1758,398 @@ namespace sgui {
 		virtual void setClipboardText(const std::string& text) = 0;
 		virtual std::string getClipboardText() = 0;
 
-		inline Key translateKey(int key) {
-			for (size_t i = 0; i < m_keymap.size(); i++) {
-				if (m_keymap[i] == key) return Key(i);
+		/**
+		 * @brief  Maps a backend key code to a Key
+		 * @param  key: The backend key code
+		 * @retval The key, or KeyCount if it is not mapped
+		 */
+		inline Key translateKey(int key) const {
+			for (unsigned i = keySlot(key); m_keyTable[i].key != KeyCount; i = (i + 1) % KeyTableSize) {
+				if (m_keyTable[i].code == key) return m_keyTable[i].key;
 			}
 			return Key::KeyCount;
 		}
 
+		/// Ends the frame, dropping its events
 		inline void clear() {
-			for (auto& [k, v] : m_mouse) {
-				v.pressed = false;
-				v.released = false;
-			}
-			for (auto& [k, v] : m_keyboard) {
-				v.pressed = false;
-				v.released = false;
-			}
+			m_buttonsPressed = m_buttonsReleased = 0;
+			m_keysPressed = m_keysReleased = 0;
+			m_frameKeysDown = m_keysDown;
 			m_char = 0;
+			m_first = m_last;
+			m_dropped = 0;
+		}
+
+		/// Events queued since the last frame, oldest first
+		inline size_t eventCount() const { return m_last - m_first; }
+
+		inline const InputEvent& event(size_t i) const { return m_queue[(m_first + i) & (QueueSize - 1)]; }
+
+		/// Events lost this frame because the queue was full
+		inline size_t droppedEvents() const { return m_dropped; }
+
+		/// Whether a key was down when the frame's events started
+		inline bool wasKeyDown(Key key) const { return m_frameKeysDown & keyBit(key); }
+
+		/**
+		 * @brief  Hands events over from another thread
+		 * @note   Switch it before that thread starts calling processEvents().
+		 * 		   Events then go through a lock-free single producer, single
+		 * 		   consumer queue, and Gui::prepare() takes the ones that arrived
+		 * 		   so far as the frame's events.
+		 * @param  threaded: Whether processEvents() runs on its own thread
+		 * @retval None
+		 */
+		inline void setThreaded(bool threaded) {
+			m_threaded = threaded;
+			if (threaded && !m_handoff) m_handoff.reset(new InputEvent[QueueSize]);
+		}
+
+		inline bool threaded() const { return m_threaded; }
+
+		/**
+		 * @brief  Called by Gui::prepare(), gathers the frame's events
+		 * @note   Decorators override it to see each frame's events and time
+		 * @retval None
+		 */
+		virtual void beginFrame() {
+			drain();
+		}
+
+		/**
+		 * @brief  Applies the events handed over by the input thread
+		 * @note   Only called from the GUI thread, does nothing unless threaded
+		 * @retval None
+		 */
+		inline void drain() {
+			if (!m_threaded) return;
+
+			const size_t last = m_handoffLast.load(std::memory_order_acquire);
+			size_t first = m_handoffFirst.load(std::memory_order_relaxed);
+			for (; first != last; first++) apply(m_handoff[first & (QueueSize - 1)]);
+			m_handoffFirst.store(first, std::memory_order_release);
+			m_dropped += m_handoffDropped.exchange(0, std::memory_order_relaxed);
 		}
 
 		inline Point mousePosition() const { return Point(m_mouseX, m_mouseY); }
 
-		inline bool isKeyPressed(Key key) { return m_keyboard[key].pressed; }
-		inline bool isKeyReleased(Key key) { return m_keyboard[key].released; }
-		inline bool isKeyDown(Key key) { return m_keyboard[key].down; }
+		inline bool isKeyPressed(Key key) const { return m_keysPressed & keyBit(key); }
+		inline bool isKeyReleased(Key key) const { return m_keysReleased & keyBit(key); }
+		inline bool isKeyDown(Key key) const { return m_keysDown & keyBit(key); }
 
-		inline bool isMouseButtonPressed(int btn) { return m_mouse[btn].pressed; }
-		inline bool isMouseButtonReleased(int btn) { return m_mouse[btn].released; }
-		inline bool isMouseButtonDown(int btn) { return m_mouse[btn].down; }
+		inline bool isMouseButtonPressed(int btn) const { return m_buttonsPressed & buttonBit(btn); }
+		inline bool isMouseButtonReleased(int btn) const { return m_buttonsReleased & buttonBit(btn); }
+		inline bool isMouseButtonDown(int btn) const { return m_buttonsDown & buttonBit(btn); }
 
 		inline char typedChar() const { return m_char; }
 
 		inline int key(Key key) const { return m_keymap[key]; }
 
+		/// Lets the backend fill the keymap, then indexes it for translateKey
+		inline void initKeymap() {
+			init(m_keymap);
+			m_keyTable.fill(KeySlot{});
+			for (int k = 0; k < KeyCount; k++) {
+				if (translateKey(m_keymap[k]) != KeyCount) continue; // first key wins, as in the keymap order
+				unsigned i = keySlot(m_keymap[k]);
+				while (m_keyTable[i].key != KeyCount) i = (i + 1) % KeyTableSize;
+				m_keyTable[i] = KeySlot{ m_keymap[k], Key(k) };
+			}
+		}
+
 	protected:
-		std::map<int, State> m_mouse;
-		std::map<Key, State> m_keyboard;
-		std::array<int, KeyCount> m_keymap;
+		/// Counts events another InputManager lost before handing its queue over
+		inline void addDroppedEvents(size_t count) { m_dropped += count; }
+
+		/// Queues an event that was already translated, e.g. by another InputManager
+		inline void queueEvent(const InputEvent& e) {
+			if ((e.type == InputEvent::EventKeyDown || e.type == InputEvent::EventKeyUp) && e.key >= KeyCount) return;
+			post(e);
+		}
+
+		inline void queueMouseMove(int x, int y, int time) {
+			InputEvent e{};
+			e.type = InputEvent::EventMouseMove;
+			e.x = x;
+			e.y = y;
+			e.time = time;
+			post(e);
+		}
+
+		inline void queueMouseButton(int btn, bool down, int x, int y, int time) {
+			InputEvent e{};
+			e.type = down ? InputEvent::EventMouseDown : InputEvent::EventMouseUp;
+			e.button = btn;
+			e.x = x;
+			e.y = y;
+			e.time = time;
+			post(e);
+		}
+
+		/// Keys that are not mapped are ignored
+		inline void queueKey(Key key, bool down, int time) {
+			if (key >= KeyCount) return;
+
+			InputEvent e{};
+			e.type = down ? InputEvent::EventKeyDown : InputEvent::EventKeyUp;
+			e.key = key;
+			e.time = time;
+			post(e);
+		}
+
+		/// Queues one event per code point of a UTF-8 string
+		inline void queueText(const char* utf8, int time) {
+			for (const char* c = utf8; *c; ) {
+				InputEvent e{};
+				e.type = InputEvent::EventText;
+				e.time = time;
+				do {
+					e.text[e.length++] = *c++;
+				} while (*c && (byte(*c) & 0xC0) == 0x80 && e.length < 4);
+				post(e);
+			}
+		}
+
+		std::array<int, KeyCount> m_keymap{};
 
 		int m_mouseX{ 0 }, m_mouseY{ 0 };
 		char m_char{ 0 };
+
+	private:
+		/// Records a key going down or up, keys that are not mapped are ignored
+		inline void setKey(Key key, bool down) {
+			const uint32_t bit = keyBit(key);
+			if (down) {
+				m_keysDown |= bit;
+				m_keysPressed |= bit;
+			} else {
+				m_keysDown &= ~bit;
+				m_keysReleased |= bit;
+			}
+		}
+
+		/// Records a mouse button going down or up
+		inline void setMouseButton(int btn, bool down) {
+			const uint32_t bit = buttonBit(btn);
+			if (down) {
+				m_buttonsDown |= bit;
+				m_buttonsPressed |= bit;
+			} else {
+				m_buttonsDown &= ~bit;
+				m_buttonsReleased |= bit;
+			}
+		}
+
+		/// Applies an event right away, or hands it to the GUI thread
+		inline void post(const InputEvent& e) {
+			if (!m_threaded) {
+				apply(e);
+				return;
+			}
+
+			const size_t last = m_handoffLast.load(std::memory_order_relaxed);
+			if (last - m_handoffFirst.load(std::memory_order_acquire) == QueueSize) {
+				m_handoffDropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			m_handoff[last & (QueueSize - 1)] = e;
+			m_handoffLast.store(last + 1, std::memory_order_release);
+		}
+
+		/// Updates the input state and appends the event to the frame's events
+		inline void apply(InputEvent e) {
+			switch (e.type) {
+				case InputEvent::EventMouseMove:
+					m_mouseX = e.x;
+					m_mouseY = e.y;
+					break;
+				case InputEvent::EventMouseDown:
+				case InputEvent::EventMouseUp:
+					m_mouseX = e.x;
+					m_mouseY = e.y;
+					setMouseButton(e.button, e.type == InputEvent::EventMouseDown);
+					break;
+				case InputEvent::EventKeyDown:
+				case InputEvent::EventKeyUp:
+					e.x = m_mouseX;
+					e.y = m_mouseY;
+					setKey(e.key, e.type == InputEvent::EventKeyDown);
+					break;
+				case InputEvent::EventText:
+					e.x = m_mouseX;
+					e.y = m_mouseY;
+					if (m_char == 0) m_char = e.text[0];
+					break;
+			}
+			queue(e);
+		}
+
+		/// Appends to the frame's events, dropping the newest ones once the queue is full
+		inline void queue(const InputEvent& e) {
+			if (m_last - m_first == QueueSize) {
+				m_dropped++;
+				return;
+			}
+			m_queue[m_last++ & (QueueSize - 1)] = e;
+		}
+
+		static_assert(KeyCount <= 32, "key state no longer fits a word");
+
+		// open addressing, at most half full so probes stay short
+		static constexpr unsigned KeyTableSize = 32;
+		static_assert(KeyTableSize >= KeyCount * 2, "key table too small");
+
+		struct KeySlot {
+			int code{ 0 };
+			Key key{ KeyCount };
+		};
+		std::array<KeySlot, KeyTableSize> m_keyTable{};
+
+		uint32_t m_buttonsDown{ 0 }, m_buttonsPressed{ 0 }, m_buttonsReleased{ 0 };
+		uint32_t m_keysDown{ 0 }, m_keysPressed{ 0 }, m_keysReleased{ 0 };
+		uint32_t m_frameKeysDown{ 0 };
+
+		std::array<InputEvent, QueueSize> m_queue{};
+		size_t m_first{ 0 }, m_last{ 0 }, m_dropped{ 0 };
+
+		// input thread to GUI thread, the indices on their own cache lines
+		bool m_threaded{ false };
+		std::unique_ptr<InputEvent[]> m_handoff;
+		alignas(64) std::atomic<size_t> m_handoffLast{ 0 };	// written by the input thread
+		alignas(64) std::atomic<size_t> m_handoffFirst{ 0 };	// written by the GUI thread
+		std::atomic<size_t> m_handoffDropped{ 0 };
+
+		static inline unsigned keySlot(int code) {
+			return (unsigned(code) * 2654435761u) >> 27; // Fibonacci hashing, 5 bits for KeyTableSize
+		}
+
+		static inline uint32_t keyBit(Key key) {
+			return key < KeyCount ? 1u << key : 0u;
+		}
+
+		static inline uint32_t buttonBit(int btn) {
+			return unsigned(btn) < unsigned(MouseButtonCount) ? 1u << btn : 0u;
+		}
+	};
+
+	/**
+	 * Laid out text of Gui::text, keyed by the text, the width left to it
+	 * and the overflow mode. Least recently used layouts are evicted once
+	 * the cache holds more than its capacity, in bytes.
+	 */
+	class TextLayoutCache {
+	public:
+		/// Glyphs drawn as one CmdDrawText, relative to the text origin
+		struct Run {
+			int x, y;
+			unsigned offset, length;
+		};
+
+		struct Layout {
+			std::string text;
+			int width{ 0 };
+			Overflow overflow{ Overflow::OverfowNone };
+
+			std::string glyphs;
+			std::vector<Run> runs;
+
+			inline size_t bytes() const {
+				return sizeof(Layout) + text.capacity() + glyphs.capacity() + runs.capacity() * sizeof(Run);
+			}
+		};
+
+		TextLayoutCache() = default;
+		inline explicit TextLayoutCache(size_t capacity) : m_capacity(capacity) {}
+
+		/**
+		 * @brief  Looks a layout up and marks it as the most recently used
+		 * @param  text: The text
+		 * @param  width: Width left to the text
+		 * @param  overflow: Overflow mode
+		 * @retval The layout, or nullptr on a miss
+		 */
+		inline const Layout* find(std::string_view text, int width, Overflow overflow) {
+			auto pos = m_index.find(key(text, width, overflow));
+			if (pos == m_index.end()) return nullptr;
+
+			const Layout& layout = *pos->second;
+			if (layout.width != width || layout.overflow != overflow || layout.text != text) return nullptr;
+
+			m_layouts.splice(m_layouts.begin(), m_layouts, pos->second);
+			return &layout;
+		}
+
+		/**
+		 * @brief  Stores a layout, replacing one with the same key
+		 * @note   Layouts larger than the whole capacity are not stored
+		 * @param  layout: The layout, its text, width and overflow filled in
+		 * @retval The stored layout, or nullptr if it was not stored
+		 */
+		inline const Layout* insert(Layout&& layout) {
+			const size_t bytes = layout.bytes();
+			if (bytes > m_capacity) return nullptr;
+
+			const uint64_t k = key(layout.text, layout.width, layout.overflow);
+			auto pos = m_index.find(k);
+			if (pos != m_index.end()) erase(pos->second);
+
+			while (m_bytes + bytes > m_capacity) erase(std::prev(m_layouts.end()));
+
+			m_layouts.push_front(std::move(layout));
+			m_index[k] = m_layouts.begin();
+			m_bytes += bytes;
+			return &m_layouts.front();
+		}
+
+		inline void clear() {
+			m_layouts.clear();
+			m_index.clear();
+			m_bytes = 0;
+		}
+
+		/**
+		 * @brief  Sets the memory cap, evicting layouts above it
+		 * @param  capacity: Maximum size in bytes, 0 disables the cache
+		 * @retval None
+		 */
+		inline void setCapacity(size_t capacity) {
+			m_capacity = capacity;
+			while (m_bytes > m_capacity) erase(std::prev(m_layouts.end()));
+		}
+
+		inline size_t capacity() const { return m_capacity; }
+		inline size_t bytes() const { return m_bytes; }
+		inline size_t size() const { return m_layouts.size(); }
+
+	private:
+		std::list<Layout> m_layouts; // most recently used first
+		std::unordered_map<uint64_t, std::list<Layout>::iterator> m_index;
+		size_t m_capacity{ SGUI_TEXT_CACHE_BYTES }, m_bytes{ 0 };
+
+		inline void erase(std::list<Layout>::iterator pos) {
+			m_bytes -= pos->bytes();
+			m_index.erase(key(pos->text, pos->width, pos->overflow));
+			m_layouts.erase(pos);
+		}
+
+		/// FNV-1a over the text, then the width and overflow mode
+		static inline uint64_t key(std::string_view text, int width, Overflow overflow) {
+			uint64_t h = 14695981039346656037ull;
+			auto mix = [&h](byte b) { h = (h ^ b) * 1099511628211ull; };
+			for (char c : text) mix(byte(c));
+			for (int i = 0; i < 4; i++) mix(byte(unsigned(width) >> (i * 8)));
+			mix(byte(overflow));
+			return h;
+		}
+	};
+
+	/**
+	 * What Gui::finish() found out about the frame, for hosts that only draw
+	 * when something changes.
+	 */
+	struct FrameStatus {
+		bool changed{ true };	// the frame draws differently than the previous one
+		int deadline{ -1 };		// InputManager::time() by which the next frame is due, -1 to wait for input
 	};
 
 	class Gui {
@@ -1234,7 +2164,7 @@ namespace sgui {
 			m_input = std::unique_ptr<InputManager>(input);
 			m_renderer = std::unique_ptr<Renderer>(renderer);
 
-			m_input->init(m_input->m_keymap);
+			m_input->initKeymap();
 
 			m_style[StyleProperty::PropAccentColor] = 0xF05522FF;
 			m_style[StyleProperty::PropPrimaryColor] = 0x555555FF;
@@ -1243,35 +2173,23 @@ namespace sgui {
 			m_style[StyleProperty::PropPadding] = 4;
 			m_style[StyleProperty::PropGap] = 4;
 
-			size_t ptr = 0;
-			std::vector<byte> pixels;
-			pixels.reserve(fontWidth * fontHeight * 4);
-			for (int y = 0; y < fontHeight; y++) {
-				for (int x = 0; x < fontWidth; x++) {
-					byte pix = (((font_data[ptr + 0] - 33) << 2) | ((font_data[ptr + 1] - 33) >> 4));
-					if (pix > 120) {
-						pixels.push_back(255);
-						pixels.push_back(255);
-						pixels.push_back(255);
-						pixels.push_back(255);
-					} else {
-						pixels.push_back(255);
-						pixels.push_back(255);
-						pixels.push_back(255);
-						pixels.push_back(0);
-					}
-					ptr += 4;
-				}
-			}
+			StartupStats& startup = m_renderer->m_startupStats;
+			auto start = StatsClock::now();
+			m_font = m_renderer->loadFont(fontAtlas.bits, fontWidth, fontHeight);
+			auto stop = StatsClock::now();
+			startup.fontUploadTime = elapsedMicros(start, stop);
 
-			m_font = m_renderer->loadFont(pixels, fontWidth, fontHeight);
+			start = stop;
 			m_renderer->created();
+			startup.createTime = elapsedMicros(start, StatsClock::now());
 		}
 
 		inline LayoutRegion pushLayout(int x, int y, int w, int h, Dock dock = Dock::DockNone, int pad = 0, int gap = -1) {
+			SGUI_PROFILE_SCOPE("Gui::pushLayout");
 			pad = pad < 0 ? m_style[StyleProperty::PropPadding] : pad;
 			gap = gap < 0 ? m_style[StyleProperty::PropGap] : gap;
-			
+			m_renderer->m_stats.layoutPushes++;
+
 			int dx = x, dy = y, dw = w, dh = h, pd = pad;
 
 			m_rects.push_back(Rect(dx, dy, dw, dh));
@@ -1361,10 +2279,8 @@ namespace sgui {
 
 		inline void pushContainer(int x, int y, int w, int h, Dock dock = Dock::DockNone, int pad = -1, int gap = -1) {
 			LayoutRegion reg = pushLayout(x, y, w, h, dock, pad, gap);
-			Rect shad(reg.area.x + 1, reg.area.y + 1, reg.area.w, reg.area.h);
-			m_renderer->rect(shad, Color(0.0f, 0.0f, 0.0f, 0.45f), true);
-			m_renderer->rect(reg.area, Color(m_style[StyleProperty::PropPrimaryColor]), true);
-			m_renderer->rect(reg.area, Color(m_style[StyleProperty::PropPrimaryColor]).bright(2.0f));
+			const Color prim = Color(m_style[StyleProperty::PropPrimaryColor]);
+			m_renderer->box(reg.area, prim, prim.bright(2.0f), 1, 1);
 			m_renderer->clip(reg.asRect());
 		}
 
@@ -1416,8 +2332,7 @@ namespace sgui {
 			popLayout();
 			popID();
 
-			m_renderer->rect(Rect(r.x + r.w - scrollSize, r.y + r.h - scrollSize, scrollSize, scrollSize), track, true);
-			m_renderer->rect(Rect(r.x + r.w - scrollSize, r.y + r.h - scrollSize, scrollSize, scrollSize), fg);
+			m_renderer->box(Rect(r.x + r.w - scrollSize, r.y + r.h - scrollSize, scrollSize, scrollSize), track, fg);
 
 			pushContainer(0, 0, w - scrollSize, h - scrollSize, Dock::DockNone, pad, 0);
 			pushLayout(0, 0, w - scrollSize, h - scrollSize, Dock::DockNone, 0, gap);
@@ -1434,7 +2349,6 @@ namespace sgui {
 		inline bool scroll(int id, float vmax, float* v, Orientation ori) {
 			const Widget w = widget(id);
 			const Rect parent = w.parent;
-			const Rect shadow{ parent.x+1, parent.y+1, parent.w , parent.h };
 
 			const float scrollSize = ori == Horizontal ? float(parent.w) : float(parent.h);
 
@@ -1475,15 +2389,13 @@ namespace sgui {
 			Color tex = Color(m_style[StyleProperty::PropTextColor]);
 			tex.a = 0.5f;
 
-			m_renderer->rect(shadow, Color(0.0f, 0.0f, 0.0f, 0.45f), true);
-			m_renderer->rect(parent, track, true);
-			m_renderer->rect(parent, fg);
+			m_renderer->box(parent, track, fg, 1, 1);
 
 			switch (w.state) {
 				default:
-				case WidgetState::StateNormal: m_renderer->rect(dstT, base, true); m_renderer->rect(dstT, fg); break;
-				case WidgetState::StateActive: m_renderer->rect(dstT1, active, true); m_renderer->rect(dstT1, fg); break;
-				case WidgetState::StateHovered: m_renderer->rect(dstT, hover, true); m_renderer->rect(dstT, fg); break;
+				case WidgetState::StateNormal: m_renderer->box(dstT, base, fg); break;
+				case WidgetState::StateActive: m_renderer->box(dstT1, active, fg); break;
+				case WidgetState::StateHovered: m_renderer->box(dstT, hover, fg); break;
 			}
 
 			if (w.state == WidgetState::StateActive) {
@@ -1507,70 +2419,51 @@ namespace sgui {
 		}
 
 		inline int chr(int x, int y, char c, Color color) {
-			c = c & 0x7F;
-			if (c < ' ') c = 0;
-			else 		 c -= ' ';
-
-			const Color fg = color;
-			const Color sh = Color(0x000000FF);
-
-			const int cw = 8;
-			const int ch = 16;
-			const Rect src{ (c % 128) * cw, 0, cw, ch };
-			Rect dst{ x, y + 1, cw, ch };
-
-			m_renderer->image(m_font, src, dst, sh);
-			dst.y--;
-			m_renderer->image(m_font, src, dst, fg);
-
-			return x + cw;
+			m_renderer->text(m_font, x, y, &c, 1, color);
+			return x + 8;
 		}
 
-		inline int textWidth(const std::string& txt) {
-			auto spl = tokenize(txt, '\n');
+		/// Width of the widest line, in pixels
+		inline int textWidth(std::string_view txt) {
 			int w = 0;
-			for (auto line : spl) w = std::max(w, int(line.size() * 8));
+			for (std::string_view rest = txt; !rest.empty(); ) {
+				const std::string_view line = token(rest, '\n');
+				w = std::max(w, int(line.size()) * 8);
+			}
 			return w;
 		}
 
-		inline int textHeight(const std::string& txt) {
-			auto spl = tokenize(txt, '\n');
-			return spl.size() * 16;
+		/// Height of the lines, in pixels. A trailing newline starts no line.
+		inline int textHeight(std::string_view txt) {
+			if (txt.empty()) return 0;
+			const int lines = 1 + int(std::count(txt.begin(), txt.end(), '\n')) - (txt.back() == '\n' ? 1 : 0);
+			return lines * 16;
 		}
 
-		inline void text(int x, int y, const std::string& txt, Color color, Overflow overflow = Overflow::OverfowNone) {
-			auto spl = tokenize(txt, ' ');
+		inline void text(int x, int y, std::string_view txt, Color color, Overflow overflow = Overflow::OverfowNone) {
+			SGUI_PROFILE_SCOPE("Gui::text");
 			Rect parent = parentRegion().asRect();
 
-			int tx = parent.x + x,
-				ty = parent.y + y;
-			bool stop = false;
-			for (auto word : spl) {
-				auto w = word;
-				if (tx + textWidth(w) > parent.w) {
-					switch (overflow) {
-						case Overflow::OverfowWrap: tx = parent.x + x; ty += 16; break;
-						case Overflow::OverfowEllipses: stop = true; w = "..."; break;
-						default: break;
-					}
-				}
-
-				for (char c : w) {
-					if (c == '\t') {
-						tx += 24;
-					} else if (c == '\n') {
-						ty += 16;
-						tx = parent.x + x;
-					} else {
-						tx = chr(tx, ty, c, color);
-					}
-				}
-				if (stop) break;
-				tx += 8;
+			const int ox = parent.x + x,
+				oy = parent.y + y;
+			// the width only matters to text that wraps or ends in ellipses, so
+			// labels that move or resize keep hitting the same cache entry
+			const int width = overflow == Overflow::OverfowNone ? 0 : parent.w - ox;
+			const TextLayoutCache::Layout& layout = layoutText(txt, width, overflow);
+
+			// runs go down the lines, seek to the first one reaching into the clip
+			auto run = layout.runs.begin(), end = layout.runs.end();
+			const Rect* clip = m_renderer->clipRect();
+			if (clip) {
+				run = std::lower_bound(run, end, clip->y - 18 - oy, [](const TextLayoutCache::Run& r, int y) { return r.y < y; });
+			}
+			for (; run != end; ++run) {
+				if (clip && oy + run->y > clip->y + clip->h) break;
+				m_renderer->text(m_font, ox + run->x, oy + run->y, layout.glyphs.data() + run->offset, run->length, color);
 			}
 		}
 
-		inline void text(int x, int y, const std::string& txt, Overflow overflow = Overflow::OverfowNone) {
+		inline void text(int x, int y, std::string_view txt, Overflow overflow = Overflow::OverfowNone) {
 			text(x, y, txt, Color(m_style[StyleProperty::PropTextColor]), overflow);
 		}
 
@@ -1586,16 +2479,15 @@ namespace sgui {
 			const Rect p = btn.parent;
 			const Rect shadow{ p.x+1, p.y+1, p.w , p.h };
 
-			m_renderer->rect(shadow, Color(0.0f, 0.0f, 0.0f, 0.45f), true);
-
 			const int tw = textWidth(text);
 			const int th = textHeight(text);
 
+			// Pressed buttons sink onto their shadow
 			switch (btn.state) {
 				default:
-				case WidgetState::StateNormal: m_renderer->rect(p, base, true); m_renderer->rect(p, fg); break;
-				case WidgetState::StateActive: m_renderer->rect(shadow, active, true); m_renderer->rect(shadow, fg); break;
-				case WidgetState::StateHovered: m_renderer->rect(p, hover, true); m_renderer->rect(p, fg); break;
+				case WidgetState::StateNormal: m_renderer->box(p, base, fg, 1, 1); break;
+				case WidgetState::StateActive: m_renderer->box(shadow, active, fg); break;
+				case WidgetState::StateHovered: m_renderer->box(p, hover, fg, 1, 1); break;
 			}
 
 			this->text(p.w / 2 - tw / 2, p.h / 2 - th / 2, text, Color(m_style[StyleProperty::PropTextColor]), Overflow::OverfowEllipses);
@@ -1606,7 +2498,6 @@ namespace sgui {
 		inline bool slider(float* v, float vmin = 0.0f, float vmax = 1.0f, const std::string& fmt = "%.3f") {
 			const Widget w = widget();
 			const Rect parent = w.parent;
-			const Rect shadow{ parent.x+1, parent.y+1, parent.w , parent.h };
 
 			const int thumbSize = 16;
 			const int width = parent.w - (thumbSize + 6);
@@ -1628,18 +2519,16 @@ namespace sgui {
 			Color tex = Color(m_style[StyleProperty::PropTextColor]);
 			tex.a = 0.5f;
 
-			m_renderer->rect(shadow, Color(0.0f, 0.0f, 0.0f, 0.45f), true);
-			m_renderer->rect(parent, track, true);
-			m_renderer->rect(parent, fg);
+			m_renderer->box(parent, track, fg, 1, 1);
 
 			auto vTxt = format(fmt, *v);
 			text(parent.w / 2 - textWidth(vTxt) / 2, parent.h / 2 - 8, vTxt, tex, Overflow::OverfowNone);
 
 			switch (w.state) {
 				default:
-				case WidgetState::StateNormal: m_renderer->rect(dstT, base, true); m_renderer->rect(dstT, fg); break;
-				case WidgetState::StateActive: m_renderer->rect(dstT1, active, true); m_renderer->rect(dstT1, fg); break;
-				case WidgetState::StateHovered: m_renderer->rect(dstT, hover, true); m_renderer->rect(dstT, fg); break;
+				case WidgetState::StateNormal: m_renderer->box(dstT, base, fg); break;
+				case WidgetState::StateActive: m_renderer->box(dstT1, active, fg); break;
+				case WidgetState::StateHovered: m_renderer->box(dstT, hover, fg); break;
 			}
 
 			if (w.state == WidgetState::StateActive) {
@@ -1666,9 +2555,9 @@ namespace sgui {
 
 			switch (w.state) {
 				default:
-				case WidgetState::StateNormal: m_renderer->rect(parent, bg, true); m_renderer->rect(parent, fg); break;
+				case WidgetState::StateNormal: m_renderer->box(parent, bg, fg); break;
 				case WidgetState::StateActive:
-				case WidgetState::StateHovered: m_renderer->rect(parent, bg1, true); m_renderer->rect(parent, fg); break;
+				case WidgetState::StateHovered: m_renderer->box(parent, bg1, fg); break;
 			}
 
 			const Rect dstC{ parent.x + pad, parent.y + 1, parent.w - pad * 2, parent.h - 2 };
@@ -1676,31 +2565,40 @@ namespace sgui {
 
 			const Point mp = m_input->mousePosition();
 
-			// Draw text
+			// Draw text, every character takes one cell like the caret and the selection
 			int caret = pad + m_state.text.cursor * 8 - 3;
 			int threshold = parent.w - (12 + pad);
 			int offset = caret > threshold ? caret - threshold : 0;
 
-			int x = parent.x + pad - offset, y = parent.y + parent.h / 2 - 8;
-			for (size_t i = 0; i <= text.size(); i++) {
-				Rect cb(x - 4, parent.y, 8, parent.h);
-				if (i == text.size()) cb.w = parent.w + offset;
-
-				if (w.state == WidgetState::StateActive && cb.contains(mp)) {
-					m_state.text.cursor = i;
-				}
+			const int x = parent.x + pad - offset, y = parent.y + parent.h / 2 - 8;
+			const int length = int(text.size());
 
-				if (i == text.size()) continue;
+			if (w.state == WidgetState::StateActive && mp.y >= parent.y && mp.y < parent.y + parent.h) {
+				// the cursor goes to the boundary closest to the mouse, the one past the end takes the rest
+				const int i = floorDiv(mp.x - x + 4, 8);
+				if (i >= 0 && i < length) m_state.text.cursor = i;
+				else if (i >= length && mp.x < x + length * 8 - 4 + parent.w + offset) m_state.text.cursor = length;
+			}
 
-				char c = text[i];
-				if (c == ' ') x += 8;
-				else if (c == '\t') x += 32;
-				else if (c == '\n') continue;
-				else x = chr(x, y, obscure ? '*' : c, color);
+			// only the characters under the clip are recorded
+			const Rect& visible = *m_renderer->clipRect();
+			const int first = std::max(0, floorDiv(visible.x - x, 8)),
+				last = std::min(length, floorDiv(visible.x + visible.w - x, 8) + 1);
+			if (first < last) {
+				const char* glyphs = text.data() + first;
+				if (obscure) {
+					m_obscured.resize(last - first);
+					for (int i = first; i < last; i++) m_obscured[i - first] = byte(text[i]) > ' ' ? '*' : ' ';
+					glyphs = m_obscured.data();
+				}
+				m_renderer->text(m_font, x + first * 8, y, glyphs, last - first, color);
 			}
 
-			if (m_state.focusedItem == id && (m_input->time() >> 8) & 1) {
-				chr(parent.x + caret - offset, y, '|', color);
+			if (m_state.focusedItem == id) {
+				// the caret blinks every 256 ms
+				const int now = m_input->time();
+				requestRedraw(((now >> 8) + 1) << 8);
+				if ((now >> 8) & 1) chr(parent.x + caret - offset, y, '|', color);
 			}
 
 			bool changed = false;
@@ -1730,85 +2628,28 @@ namespace sgui {
 				// 	m_state.text.cursor = 0;
 				// }
 
-				bool ctrl = false;
-				if (m_input->isKeyDown(Key::KeyCtrl)) {
-					ctrl = true;
-					if (m_state.text.selectionStart != -1) {
-						int selStart = m_state.text.selectionStart, selEnd = m_state.text.cursor;
-						if (selStart > selEnd) std::swap(selStart, selEnd);
-						
-						// Handle clipboard
-						if (m_input->isKeyPressed(Key::KeyC)) {
-							m_input->setClipboardText(text.substr(selStart, selEnd - selStart));
-						} else if (m_input->isKeyPressed(Key::KeyX)) {
-							m_input->setClipboardText(text.substr(selStart, selEnd - selStart));
-							changed = clearTextSelection(text);
-						} else if (m_input->isKeyPressed(Key::KeyV)) {
-							changed = clearTextSelection(text);
-							std::string txt = m_input->getClipboardText();
-							for (char c : txt) {
-								text.insert(text.begin() + cursor, c);
+				// every key and character of the frame, in the order they came in
+				bool ctrl = m_input->wasKeyDown(Key::KeyCtrl);
+				for (size_t i = 0; i < m_input->eventCount(); i++) {
+					const InputEvent& e = m_input->event(i);
+					switch (e.type) {
+						case InputEvent::EventKeyDown:
+							if (e.key == Key::KeyCtrl) ctrl = true;
+							else changed |= editKey(text, e.key, ctrl);
+							break;
+						case InputEvent::EventKeyUp:
+							if (e.key == Key::KeyCtrl) ctrl = false;
+							break;
+						case InputEvent::EventText:
+							// the font only covers ASCII
+							if (e.length == 1 && e.text[0] >= 32 && !ctrl) {
+								clearTextSelection(text);
+								text.insert(text.begin() + cursor, e.text[0]);
 								cursor++;
+								changed = true;
 							}
-							changed = true;
-						}
-					} else {
-						// Special navigation
-						if (m_input->isKeyPressed(Key::KeyBackspace) && text.size() > 0) {
-							int end = cursor;
-							while (cursor > 0 && text[--cursor] != ' ');
-							text.erase(text.begin() + cursor, text.begin() + end);
-							changed = true;
-						} else if (m_input->isKeyPressed(Key::KeyDelete)) {
-							while (text[cursor] != ' ' && text.size() - cursor > 0) {
-								text.erase(text.begin() + cursor);
-							}
-							if (text.size() - cursor > 0)
-								text.erase(text.begin() + cursor);
-							changed = true;
-						} else if (m_input->isKeyPressed(Key::KeyLeft)) {
-							while (cursor > 0 && text[--cursor] != ' ');
-						} else if (m_input->isKeyPressed(Key::KeyRight)) {
-							while (cursor < text.size() && text[++cursor] != ' ');
-						}
-					}
-				} else if (m_input->isKeyPressed(Key::KeyBackspace) && !ctrl) {
-					if (m_state.text.selectionStart != -1) {
-						changed = clearTextSelection(text);
-					} else {
-						if (cursor > 0) {
-							text.erase(text.begin() + (--cursor));
-							changed = true;
-						}
-					}
-				} else if (m_input->isKeyPressed(Key::KeyDelete) && !ctrl) {
-					if (m_state.text.selectionStart != -1) {
-						changed = clearTextSelection(text);
-					} else {
-						int len = text.size() - cursor;
-						if (len > 0) {
-							text.erase(text.begin() + cursor);
-							changed = true;
-						}
-					}
-				} else if (m_input->isKeyPressed(Key::KeyHome) && !ctrl) {
-					m_state.text.selectionStart = -1;
-					cursor = 0;
-				} else if (m_input->isKeyPressed(Key::KeyEnd) && !ctrl) {
-					m_state.text.selectionStart = -1;
-					cursor = text.size();
-				} else if (m_input->isKeyPressed(Key::KeyLeft) && !ctrl) {
-					m_state.text.selectionStart = -1;
-					if (cursor > 0) cursor--;
-				} else if (m_input->isKeyPressed(Key::KeyRight) && !ctrl) {
-					m_state.text.selectionStart = -1;
-					if (cursor < text.size()) cursor++;
-				} else {
-					if (m_input->typedChar() >= 32 && m_input->typedChar() <= 127 && !ctrl) {
-						clearTextSelection(text);
-						text.insert(text.begin() + cursor, m_input->typedChar());
-						cursor++;
-						changed = true;
+							break;
+						default: break;
 					}
 				}
 			}
@@ -1830,18 +2671,13 @@ namespace sgui {
 			const Rect p = btn.parent;
 			const Rect shadow{ p.x+1, p.y+1, p.w , p.h };
 
-			m_renderer->rect(shadow, Color(0.0f, 0.0f, 0.0f, 0.45f), true);
-
 			const int tw = textWidth(text);
 			const int th = textHeight(text);
 
 			if (*v || btn.state == WidgetState::StateActive) {
-				m_renderer->rect(shadow, active, true); m_renderer->rect(shadow, fg);
+				m_renderer->box(shadow, active, fg);
 			} else {
-				m_renderer->rect(p, base, true); m_renderer->rect(p, fg);
-				if (btn.state == WidgetState::StateHovered) {
-					m_renderer->rect(p, hover, true); m_renderer->rect(p, fg);
-				}
+				m_renderer->box(p, btn.state == WidgetState::StateHovered ? hover : base, fg, 1, 1);
 			}
 			this->text(p.w / 2 - tw / 2, p.h / 2 - th / 2, text, Color(m_style[StyleProperty::PropTextColor]), Overflow::OverfowNone);
 
@@ -1872,7 +2708,7 @@ namespace sgui {
 			for (int i = 0; i < items.size(); i++) {
 				if (y >= parent.h - 6) break;
 
-				auto it = items[i];
+				const std::string& it = items[i];
 				Rect ir(parent.x + 3, parent.y + y, parent.w - 6, 16);
 				if (w.state == WidgetState::StatePressed && ir.contains(m_input->mousePosition())) {
 					*selected = i;
@@ -1930,11 +2766,8 @@ namespace sgui {
 
 				pushLayout(0, btn.parent.h, mw, (items.size() * 16) + 16, DockNone, 4, 2);
 					LayoutRegion pr = parentRegion();
-					const Rect shad = Rect(pr.area.x + 1, pr.area.y + 2, pr.area.w, pr.area.h);
-					m_renderer->pushZIndex(SGUI_RENDERER_PRIORITY_HIGHEST);
-						m_renderer->rect(shad, Color(0.0f, 0.0f, 0.0f, 0.45f), true);
-						m_renderer->rect(pr.area, base, true);
-						m_renderer->rect(pr.area, fg);
+					m_renderer->pushLayer(LayerPopup);
+						m_renderer->box(pr.area, base, fg, 1, 2);
 
 						int y = pr.pad;
 						int i = 0;
@@ -1969,7 +2802,7 @@ namespace sgui {
 								i++;
 							}
 						}
-					m_renderer->popZIndex();
+					m_renderer->popLayer();
 				popLayout();
 			} else {
 				if (btn.state == WidgetState::StatePressed && m_state.focusedItem == btn.id) {
@@ -2027,17 +2860,83 @@ namespace sgui {
 		inline int currentID() const { return m_id - 1; }
 
 		inline void prepare() {
+			m_buildStart = StatsClock::now();
+			m_input->beginFrame();
 			m_renderer->begin();
-			m_renderer->unclip();
+			m_renderer->resetClip();
 			m_id = 0;
+			m_deadline = -1;
+		}
+
+		/**
+		 * @brief  Whether the frame built so far draws differently than the last one
+		 * @note   For hosts that clear the screen before finish(), so an unchanged
+		 * 		   frame costs no rendering API calls at all
+		 * @retval True if finish() would draw the frame
+		 */
+		inline bool frameChanged() const {
+			return !m_hasFrame || m_renderer->commandHash() != m_frameHash;
 		}
 
-		inline void finish(int width, int height) {
+		/**
+		 * @brief  Draws the frame, if it changed
+		 * @note   A frame that changed or took input asks for the next one right
+		 * 		   away, since the application may react to it after the widgets
+		 * 		   were built. Otherwise the next frame may wait for input or
+		 * 		   for the deadline.
+		 * @param  width: Viewport width
+		 * @param  height: Viewport height
+		 * @param  redraw: Draws an unchanged frame too, e.g. after the host
+		 * 		   cleared the screen or the window was exposed
+		 * @retval Whether the frame changed and when the next one is due
+		 */
+		inline FrameStatus finish(int width, int height, bool redraw = false) {
+			FrameStatus status{};
+			const uint64_t hash = m_renderer->commandHash();
+			status.changed = !m_hasFrame || hash != m_frameHash;
+			m_frameHash = hash;
+			m_hasFrame = true;
+
+			if (status.changed || m_input->eventCount() > 0) requestRedraw(m_input->time());
+			status.deadline = m_deadline;
+
+			m_renderer->m_stats.inputEvents = int(m_input->eventCount());
+			m_renderer->m_stats.droppedInputEvents = int(m_input->droppedEvents());
 			m_input->clear();
-			m_renderer->unclip();
-			m_renderer->finish(width, height);
+			m_renderer->resetClip();
+			m_renderer->m_stats.buildTime = elapsedMicros(m_buildStart, StatsClock::now());
+			m_renderer->finish(width, height, status.changed || redraw);
+			return status;
 		}
 
+		/**
+		 * @brief  Asks for a frame by the given time, even if no input comes in
+		 * @note   For animations and timers, only lasts for the frame being built
+		 * @param  time: The deadline, in InputManager::time() milliseconds
+		 * @retval None
+		 */
+		inline void requestRedraw(int time) {
+			if (m_deadline < 0 || time < m_deadline) m_deadline = time;
+		}
+
+		/**
+		 * @brief  Statistics of the last frame, valid after finish()
+		 * @retval The frame stats
+		 */
+		inline const FrameStats& stats() const { return m_renderer->stats(); }
+
+		/**
+		 * @brief  Where the constructor spent its time
+		 * @retval The startup stats
+		 */
+		inline const StartupStats& startupStats() const { return m_renderer->startupStats(); }
+
+		/**
+		 * @brief  Layouts of text(), see FrameStats::textCacheHits
+		 * @retval The cache, to read its size or change its capacity
+		 */
+		inline TextLayoutCache& textCache() { return m_textCache; }
+
 	protected:
 		struct TextBoxState {
 			int cursor{ 0 }, selectionStart{ -1 };
@@ -2062,7 +2961,168 @@ namespace sgui {
 		std::array<int, StylePropCount> m_style;
 		void* m_font;
 
+		TextLayoutCache m_textCache;
+		TextLayoutCache::Layout m_layout; // laid out here on a miss
+		std::string m_obscured; // visible part of a password edit
+
 		int m_id{ 0 };
+		StatsClock::time_point m_buildStart{};
+
+		int m_deadline{ -1 };
+		uint64_t m_frameHash{ 0 };
+		bool m_hasFrame{ false };
+
+		/// Cached layout of text(), width is what is left of the parent after the origin
+		inline const TextLayoutCache::Layout& layoutText(std::string_view txt, int width, Overflow overflow) {
+			if (const TextLayoutCache::Layout* layout = m_textCache.find(txt, width, overflow)) {
+				m_renderer->m_stats.textCacheHits++;
+				return *layout;
+			}
+			m_renderer->m_stats.textCacheMisses++;
+
+			m_layout.text.assign(txt.data(), txt.size());
+			m_layout.width = width;
+			m_layout.overflow = overflow;
+			m_layout.glyphs.clear();
+			m_layout.runs.clear();
+
+			int tx = 0, ty = 0;
+			bool stop = false;
+			for (std::string_view rest = txt; !rest.empty(); ) {
+				std::string_view w = token(rest, ' ');
+				if (tx + textWidth(w) > width) {
+					switch (overflow) {
+						case Overflow::OverfowWrap: tx = 0; ty += 16; break;
+						case Overflow::OverfowEllipses: stop = true; w = "..."; break;
+						default: break;
+					}
+				}
+
+				for (char c : w) {
+					if (c == '\t') {
+						tx += 24;
+					} else if (c == '\n') {
+						ty += 16;
+						tx = 0;
+					} else {
+						layoutGlyph(tx, ty, c);
+						tx += 8;
+					}
+				}
+				if (stop) break;
+				tx += 8;
+			}
+
+			if (m_textCache.capacity() > 0) {
+				if (const TextLayoutCache::Layout* layout = m_textCache.insert(TextLayoutCache::Layout(m_layout))) return *layout;
+			}
+			return m_layout;
+		}
+
+		/// Adds a glyph to the layout, words one space apart on a line join the same run
+		inline void layoutGlyph(int x, int y, char c) {
+			if (!m_layout.runs.empty()) {
+				TextLayoutCache::Run& run = m_layout.runs.back();
+				const int end = run.x + int(run.length) * 8;
+				if (y == run.y && (x == end || x == end + 8)) {
+					if (x != end) {
+						m_layout.glyphs.push_back(' ');
+						run.length++;
+					}
+					m_layout.glyphs.push_back(c);
+					run.length++;
+					return;
+				}
+			}
+			m_layout.runs.push_back(TextLayoutCache::Run{ x, y, unsigned(m_layout.glyphs.size()), 1 });
+			m_layout.glyphs.push_back(c);
+		}
+
+		/// Applies one key press to the focused edit box
+		inline bool editKey(std::string& text, Key key, bool ctrl) {
+			int& cursor = m_state.text.cursor;
+			bool changed = false;
+
+			if (ctrl) {
+				if (m_state.text.selectionStart != -1) {
+					int selStart = m_state.text.selectionStart, selEnd = m_state.text.cursor;
+					if (selStart > selEnd) std::swap(selStart, selEnd);
+
+					// Handle clipboard
+					if (key == Key::KeyC) {
+						m_input->setClipboardText(text.substr(selStart, selEnd - selStart));
+					} else if (key == Key::KeyX) {
+						m_input->setClipboardText(text.substr(selStart, selEnd - selStart));
+						changed = clearTextSelection(text);
+					} else if (key == Key::KeyV) {
+						changed = clearTextSelection(text);
+						std::string txt = m_input->getClipboardText();
+						for (char c : txt) {
+							text.insert(text.begin() + cursor, c);
+							cursor++;
+						}
+						changed = true;
+					}
+				} else {
+					// Special navigation
+					if (key == Key::KeyBackspace && text.size() > 0) {
+						int end = cursor;
+						while (cursor > 0 && text[--cursor] != ' ');
+						text.erase(text.begin() + cursor, text.begin() + end);
+						changed = true;
+					} else if (key == Key::KeyDelete) {
+						while (cursor < int(text.size()) && text[cursor] != ' ') {
+							text.erase(text.begin() + cursor);
+						}
+						if (cursor < int(text.size()))
+							text.erase(text.begin() + cursor);
+						changed = true;
+					} else if (key == Key::KeyLeft) {
+						while (cursor > 0 && text[--cursor] != ' ');
+					} else if (key == Key::KeyRight) {
+						while (cursor < int(text.size()) && text[++cursor] != ' ');
+					}
+				}
+				return changed;
+			}
+
+			switch (key) {
+				case Key::KeyBackspace:
+					if (m_state.text.selectionStart != -1) {
+						changed = clearTextSelection(text);
+					} else if (cursor > 0) {
+						text.erase(text.begin() + (--cursor));
+						changed = true;
+					}
+					break;
+				case Key::KeyDelete:
+					if (m_state.text.selectionStart != -1) {
+						changed = clearTextSelection(text);
+					} else if (int(text.size()) - cursor > 0) {
+						text.erase(text.begin() + cursor);
+						changed = true;
+					}
+					break;
+				case Key::KeyHome:
+					m_state.text.selectionStart = -1;
+					cursor = 0;
+					break;
+				case Key::KeyEnd:
+					m_state.text.selectionStart = -1;
+					cursor = text.size();
+					break;
+				case Key::KeyLeft:
+					m_state.text.selectionStart = -1;
+					if (cursor > 0) cursor--;
+					break;
+				case Key::KeyRight:
+					m_state.text.selectionStart = -1;
+					if (cursor < int(text.size())) cursor++;
+					break;
+				default: break;
+			}
+			return changed;
+		}
 
 		inline bool clearTextSelection(std::string& text) {
 			if (m_state.text.selectionStart != -1) {
@@ -2076,18 +3136,26 @@ namespace sgui {
 			return false;
 		}
 
-		inline std::vector<std::string> tokenize(const std::string& str, char delim)  {
-			std::vector<std::string> tokens;
-			std::stringstream   ss(str);
-			std::string         temp;
-			while(std::getline(ss, temp, delim)) {
-				tokens.push_back(temp);
-			}
-			return tokens;
+		/**
+		 * @brief  Splits the next token off a string, like std::getline does
+		 * @note   Never allocates, the delimiter is found with memchr
+		 * @param  rest: The text left to scan, advanced past the token and its delimiter
+		 * @param  delim: Delimiter
+		 * @retval The token, a view into rest
+		 */
+		static inline std::string_view token(std::string_view& rest, char delim) {
+			const char* found = (const char*) std::memchr(rest.data(), delim, rest.size());
+			const size_t length = found ? size_t(found - rest.data()) : rest.size();
+			const std::string_view tok = rest.substr(0, length);
+			rest.remove_prefix(found ? length + 1 : length);
+			return tok;
 		}
 
 		inline Widget widget(int ovid = -1) {
+			SGUI_PROFILE_SCOPE("Gui::widget");
 			const int id = ovid == -1 ? newID() : ovid;
+			m_renderer->m_stats.widgets++;
+
 			Rect prect = parentRect();
 			Rect parent = parentRegion().asRect();
 			Rect clickableArea = prect.intersection(parent);
@@ -2123,11 +3191,11 @@ namespace sgui {
 				}
 			}
 
-			// m_renderer->pushZIndex(999999);
+			// m_renderer->pushLayer(LayerDebug);
 			// m_renderer->rect(prect, Color(1.0f, 0.0f, 0.0f, 1.0f));
 			// m_renderer->rect(parent, Color(0.0f, 1.0f, 0.0f, 1.0f));
 			// m_renderer->rect(clickableArea, Color(0.0f, 0.0f, 1.0f, 1.0f));
-			// m_renderer->popZIndex();
+			// m_renderer->popLayer();
 
 			return wg;
 		}
@@ -10,17 +10,111 @@
 #else
 
 #include <iostream>
+#include <fstream>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// GL_ARB_buffer_storage (core in 4.4), loaded at runtime when available
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// GL_ARB_get_program_binary (core in 4.1), loaded at runtime when available
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
 
-#define SGUI_GL3_MAX_VERTICES 100000
+// Initial capacity of an instance buffer region, grown on demand
+#define SGUI_GL3_MAX_INSTANCES 32768
+// Regions the streaming buffer cycles through, so the CPU writes one while the GPU reads the others
+#define SGUI_GL3_STREAM_REGIONS 3
 namespace sgui {
 	struct Texture { GLuint id{ 0 }; int w, h; };
-	struct Vert { float x, y, u, v, r, g, b, a; };
-	struct Batch { int offset{ 0 }, length{ 0 }; GLenum prim{ 0 }; Texture tex{}; Rect scissor{ 0, 0, 0, 0 }; };
-	struct Glyph { std::vector<Vert> vertices; Texture tex{}; Rect scissor{ 0, 0, 0, 0 }; GLuint prim{ 0 }; };
+
+	/**
+	 * One primitive, expanded to a quad by the vertex shader.
+	 * Boxes carry their border and shadow, so a whole widget frame is a
+	 * single instance. Lines use the rect as their end points.
+	 */
+	struct Instance {
+		enum Kind : byte {
+			KindQuad = 0,	// textured quad, color is the tint
+			KindBox,		// fill, border and drop shadow
+			KindLine		// one pixel thick line, both ends inclusive
+		};
+
+		short x1, y1, x2, y2;			// rect, or line end points
+		unsigned short u1, v1, u2, v2;	// normalized 16 bit UV rect
+		Color32 color;					// tint or fill
+		Color32 color2;					// border
+		short cx1, cy1, cx2, cy2;		// clip box
+		byte kind, border, shadowAlpha;
+		signed char shadowOffset;
+	};
+	static_assert(sizeof(Instance) == 36, "GL3 instances are expected to be 36 bytes");
+	struct Batch { int offset{ 0 }, length{ 0 }; Texture tex{}; };
+
+	/**
+	 * How GL3Renderer streams its instances to the GPU.
+	 */
+	enum GL3StreamMode {
+		StreamAuto = 0,			// Persistent if supported, Unsynchronized otherwise
+		StreamPersistent,		// Persistently mapped ring with fences (GL_ARB_buffer_storage)
+		StreamUnsynchronized,	// Ring of regions mapped with GL_MAP_UNSYNCHRONIZED_BIT, fenced
+		StreamOrphan			// Single region, orphaned with glBufferData each frame
+	};
 
 	class GL3Renderer : public Renderer {
 	public:
-		inline void* loadFont(const std::vector<byte>& pixels, int width, int height) override {
+		typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+		typedef void (APIENTRYP DrawArraysInstancedBaseInstanceProc)(GLenum mode, GLint first, GLsizei count, GLsizei instances, GLuint baseInstance);
+		typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei size, GLsizei* length, GLenum* format, void* binary);
+		typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum format, const void* binary, GLsizei length);
+		typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum name, GLint value);
+
+		/**
+		 * @param  loader: GL function loader (e.g. SDL_GL_GetProcAddress), used for
+		 * 		   entry points glad was not generated with. May be nullptr.
+		 * @param  mode: Instance streaming mode, falls back if unsupported
+		 */
+		inline GL3Renderer(GLADloadproc loader = nullptr, GL3StreamMode mode = StreamAuto)
+			: m_loader(loader), m_streamMode(mode)
+		{}
+
+		/// The streaming mode in use, valid after created()
+		inline GL3StreamMode streamMode() const { return m_streamMode; }
+
+		/**
+		 * @brief  Caches the linked shader program in a file across launches
+		 * @note   Call it before the Gui is created. Needs a loader and GL 4.1 or
+		 * 		   GL_ARB_get_program_binary. The file is rebuilt whenever the driver
+		 * 		   or the shaders change, any failure falls back to compiling.
+		 * @param  path: Cache file, empty to disable the cache
+		 * @retval None
+		 */
+		inline void setProgramCache(const std::string& path) { m_programCache = path; }
+
+		inline void* loadFont(const byte* bits, int width, int height) override {
+			// GL has no 1 bit format, expand to one coverage byte per pixel
+			const int pitch = (width + 7) / 8;
+			std::vector<byte> coverage(size_t(width) * height);
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					coverage[y * width + x] = (bits[y * pitch + x / 8] & (0x80 >> (x % 8))) ? 255 : 0;
+				}
+			}
+
 			m_font.w = width;
 			m_font.h = height;
 			glGenTextures(1, &m_font.id);
@@ -29,43 +123,98 @@ namespace sgui {
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+			// Samples as white with the coverage as alpha, like an RGBA image would
+			const GLint swizzle[] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+			glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, coverage.data());
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 			glBindTexture(GL_TEXTURE_2D, 0);
 			return (void*) &m_font;
 		}
 
 		inline void created() override {
-			glGenBuffers(1, &m_vbo);
-			glGenVertexArrays(1, &m_vao);
-
-			glBindVertexArray(m_vao);
-			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-			glBufferData(GL_ARRAY_BUFFER, SGUI_GL3_MAX_VERTICES * sizeof(Vert), nullptr, GL_DYNAMIC_DRAW);
+			if (m_streamMode == StreamAuto || m_streamMode == StreamPersistent) {
+				const bool core = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4);
+				if (m_loader && (core || hasExtension("GL_ARB_buffer_storage"))) {
+					m_bufferStorage = (BufferStorageProc) m_loader("glBufferStorage");
+				}
+				m_streamMode = m_bufferStorage ? StreamPersistent : StreamUnsynchronized;
+			}
 
-			glEnableVertexAttribArray(0);
-			glEnableVertexAttribArray(1);
-			glEnableVertexAttribArray(2);
-			glVertexAttribPointer(0, 2, GL_FLOAT, false, sizeof(Vert), (void*) 0);
-			glVertexAttribPointer(1, 2, GL_FLOAT, false, sizeof(Vert), (void*) 8);
-			glVertexAttribPointer(2, 4, GL_FLOAT, false, sizeof(Vert), (void*) 16);
+			// Without it every batch re-points the attributes at its first instance
+			const bool baseInstance = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 2);
+			if (m_loader && (baseInstance || hasExtension("GL_ARB_base_instance"))) {
+				m_drawBaseInstance = (DrawArraysInstancedBaseInstanceProc) m_loader("glDrawArraysInstancedBaseInstance");
+			}
 
-			glBindVertexArray(0);
+			glGenVertexArrays(1, &m_vao);
+			createStream(SGUI_GL3_MAX_INSTANCES);
+			m_instances.reserve(SGUI_GL3_MAX_INSTANCES);
 
 			const char* vert = R"(
 #version 330 core
-layout (location = 0) in vec2 vPos;
-layout (location = 1) in vec2 vTex;
-layout (location = 2) in vec4 vCol;
+layout (location = 0) in vec4 iRect;
+layout (location = 1) in vec4 iTex;
+layout (location = 2) in vec4 iColor;
+layout (location = 3) in vec4 iColor2;
+layout (location = 4) in vec4 iClip;
+layout (location = 5) in uvec4 iStyle; // kind, border, shadow alpha, shadow offset
 
 uniform mat4 uProj;
 
+out vec2 oPos;
 out vec2 oTex;
-out vec4 oCol;
+flat out vec4 oColor;
+flat out vec4 oColor2;
+flat out vec4 oRect;
+flat out vec4 oClip;
+flat out uint oKind;
+flat out vec3 oStyle; // border, shadow offset, shadow alpha
+
+const uint KindBox = 1u;
+const uint KindLine = 2u;
 
 void main() {
-	gl_Position = uProj * vec4(vPos, 0.0, 1.0);
-	oTex = vTex;
-	oCol = vCol;
+	vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+	float shadow = float(int(iStyle.w) - (iStyle.w > 127u ? 256 : 0));
+	vec2 pos;
+
+	if (iStyle.x == KindLine) {
+		// Parallelogram along the major axis, one pixel past the far end
+		vec2 a = iRect.xy, b = iRect.zw, d = b - a;
+		if (abs(d.x) >= abs(d.y)) {
+			if (d.x >= 0.0) b.x += 1.0; else a.x += 1.0;
+			pos = mix(a, b, corner.x) + vec2(0.0, corner.y);
+		} else {
+			if (d.y >= 0.0) b.y += 1.0; else a.y += 1.0;
+			pos = mix(a, b, corner.x) + vec2(corner.y, 0.0);
+		}
+		oTex = iTex.xy;
+	} else {
+		vec4 bounds = iRect;
+		if (iStyle.x == KindBox) {
+			bounds.xy = min(bounds.xy, bounds.xy + shadow);
+			bounds.zw = max(bounds.zw, bounds.zw + shadow);
+		}
+
+		// Clipped here, so clip changes never break a batch
+		vec4 clipped = vec4(max(bounds.xy, iClip.xy), min(bounds.zw, iClip.zw));
+		clipped.zw = max(clipped.zw, clipped.xy);
+		pos = mix(clipped.xy, clipped.zw, corner);
+		oTex = mix(iTex.xy, iTex.zw, (pos - bounds.xy) / max(bounds.zw - bounds.xy, vec2(1.0)));
+	}
+
+	gl_Position = uProj * vec4(pos, 0.0, 1.0);
+	oPos = pos;
+	oColor = iColor;
+	oColor2 = iColor2;
+	oRect = iRect;
+	oClip = iClip;
+	oKind = iStyle.x;
+	oStyle = vec3(float(iStyle.y), shadow, float(iStyle.z) / 255.0);
 }
 			)";
 
@@ -73,222 +222,775 @@ void main() {
 #version 330 core
 out vec4 fragColor;
 
-uniform bool uTexOn;
 uniform sampler2D uTex;
 
+in vec2 oPos;
 in vec2 oTex;
-in vec4 oCol;
+flat in vec4 oColor;
+flat in vec4 oColor2;
+flat in vec4 oRect;
+flat in vec4 oClip;
+flat in uint oKind;
+flat in vec3 oStyle;
+
+const uint KindBox = 1u;
+const uint KindLine = 2u;
+
+bool outside(vec2 p, vec4 box) {
+	return any(lessThan(p, box.xy)) || any(greaterThanEqual(p, box.zw));
+}
 
 void main() {
-	vec4 col = oCol;
-	if (uTexOn) col *= texture(uTex, oTex);
-	fragColor = col;
+	if (oKind == KindLine) {
+		if (outside(oPos, oClip)) discard;
+		fragColor = oColor;
+	} else if (oKind == KindBox) {
+		if (!outside(oPos, oRect)) {
+			vec2 edge = min(oPos - oRect.xy, oRect.zw - oPos);
+			fragColor = min(edge.x, edge.y) < oStyle.x ? oColor2 : oColor;
+		} else {
+			if (outside(oPos - oStyle.y, oRect)) discard;
+			fragColor = vec4(0.0, 0.0, 0.0, oStyle.z);
+		}
+	} else {
+		fragColor = oColor * texture(uTex, oTex);
+	}
 }
 			)";
 
-			GLuint vs = createShader(vert, GL_VERTEX_SHADER);
-			GLuint fs = createShader(frag, GL_FRAGMENT_SHADER);
-			
-			m_shader = glCreateProgram();
-			glAttachShader(m_shader, vs);
-			glAttachShader(m_shader, fs);
-			glLinkProgram(m_shader);
-
-			char log[1024];
-			glGetProgramInfoLog(m_shader, 1024, nullptr, log);
-			std::cerr << log << std::endl;
+			const auto start = StatsClock::now();
+			buildProgram(vert, frag);
+			m_startupStats.shaderBuildTime = elapsedMicros(start, StatsClock::now());
 
-			m_uTex   = glGetUniformLocation(m_shader, "uTex");
-			m_uProj  = glGetUniformLocation(m_shader, "uProj");
-			m_uTexOn = glGetUniformLocation(m_shader, "uTexOn");
+			// uTex is left at its default, texture unit 0
+			m_uProj = glGetUniformLocation(m_shader, "uProj");
 		}
 
 		inline void destroyed() override {
-			glDeleteBuffers(1, &m_vbo);
+			releaseStream();
 			glDeleteVertexArrays(1, &m_vao);
 			glDeleteTextures(1, &m_font.id);
 			glDeleteProgram(m_shader);
 		}
 
 		void updateBuffer() {
-			std::vector<Vert> verts;
-			verts.reserve(SGUI_GL3_MAX_VERTICES);
-			
-			Glyph first = m_glyphs[0];
-			Batch b{};
-			b.offset = 0;
-			b.length = first.vertices.size();
-			b.prim = first.prim;
-			b.tex = first.tex;
-			b.scissor = first.scissor;
-			m_batches.push_back(b);
-
-			verts.insert(verts.end(), first.vertices.begin(), first.vertices.end());
-
-			int off = 0;
-			for (size_t i = 1; i < m_glyphs.size(); i++) {
-				Glyph curr = m_glyphs[i];
-				Glyph prev = m_glyphs[i - 1];
-				if (curr.tex.id != prev.tex.id || curr.prim != prev.prim) {
-					off += m_batches.back().length;
-					Batch b{};
-					b.offset = off;
-					b.length = curr.vertices.size();
-					b.prim = curr.prim;
-					b.tex = curr.tex;
-					b.scissor = curr.scissor;
-					m_batches.push_back(b);
+			SGUI_PROFILE_SCOPE("GL3Renderer::updateBuffer");
+			if (m_instances.size() > m_regionSize) {
+				size_t size = m_regionSize;
+				while (size < m_instances.size()) size *= 2;
+				createStream(size);
+			}
+
+			const size_t bytes = m_instances.size() * sizeof(Instance);
+			bindArrayBuffer(m_vbo);
+			if (m_streamMode == StreamOrphan) {
+				glBufferData(GL_ARRAY_BUFFER, m_regionSize * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+				glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_instances.data());
+				m_stats.glCalls += 2;
+				m_regionOffset = 0;
+			} else {
+				m_region = (m_region + 1) % SGUI_GL3_STREAM_REGIONS;
+				waitRegion(m_region);
+				m_regionOffset = m_region * m_regionSize;
+
+				if (m_streamMode == StreamPersistent) {
+					std::memcpy(m_mapped + m_regionOffset, m_instances.data(), bytes);
 				} else {
-					m_batches.back().length += curr.vertices.size();
+					const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+					void* dst = glMapBufferRange(GL_ARRAY_BUFFER, m_regionOffset * sizeof(Instance), bytes, access);
+					m_stats.glCalls++;
+					if (dst) {
+						std::memcpy(dst, m_instances.data(), bytes);
+						glUnmapBuffer(GL_ARRAY_BUFFER);
+						m_stats.glCalls++;
+					}
 				}
-				verts.insert(verts.end(), curr.vertices.begin(), curr.vertices.end());
 			}
 
-			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, verts.size() * sizeof(Vert), verts.data());
-
-			m_glyphs.clear();
+			m_stats.batches += int(m_batches.size());
+			m_stats.instances += m_instances.size();
+			m_stats.vertices += m_instances.size() * 4;
+			m_stats.uploadBytes += bytes;
 		}
 
 		virtual void end(int width, int height) {
-			if (m_glyphs.empty()) return;
+			SGUI_PROFILE_SCOPE("GL3Renderer::end");
+			if (m_instances.empty()) {
+				m_batches.clear();
+				return;
+			}
+
+			// The host may have changed anything since the last frame
+			if (!m_hostOwnsState) m_cache = StateCache{};
 
 			updateBuffer();
 
-			int vp[4];
-			glGetIntegerv(GL_VIEWPORT, vp);
-			glViewport(0, 0, width, height);
-
-			GLint prog; glGetIntegerv(GL_CURRENT_PROGRAM, &prog);
-			glUseProgram(m_shader);
-
-			float m[16]; ortho(0, width, height, 0, -1, 1, m);
-			glUniformMatrix4fv(m_uProj, 1, true, m);
-			glUniform1i(m_uTex, 0);
-
-			bool hasDepth = glIsEnabled(GL_DEPTH_TEST);
-			bool hasScissor = glIsEnabled(GL_SCISSOR_TEST);
-			bool hasCull = glIsEnabled(GL_CULL_FACE);
-			bool hasBlend = glIsEnabled(GL_BLEND);
-			GLint bsrc, bdest;
-			glGetIntegerv(GL_BLEND_SRC, &bsrc);
-			glGetIntegerv(GL_BLEND_DST, &bdest);
-
-			if (!hasScissor) glEnable(GL_SCISSOR_TEST);
-			if (hasDepth) glDisable(GL_DEPTH_TEST);
-			if (hasCull) glDisable(GL_CULL_FACE);
-			if (!hasBlend) {
-				glEnable(GL_BLEND);
-				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			StateCache host{};
+			if (!m_hostOwnsState) {
+				saveHostState();
+				host = m_cache;
 			}
 
-			glBindVertexArray(m_vao);
-			for (auto b : m_batches) {
-				if (b.tex.id != 0) {
-					glBindTexture(GL_TEXTURE_2D, b.tex.id);
-					glActiveTexture(GL_TEXTURE0);
-					glUniform1i(m_uTexOn, 1);
+			setViewport(0, 0, width, height);
+			useProgram(m_shader);
+
+			// Uniforms live in the program, so they survive across frames in both modes
+			if (m_projWidth != width || m_projHeight != height) {
+				float m[16]; ortho(0, width, height, 0, -1, 1, m);
+				glUniformMatrix4fv(m_uProj, 1, true, m);
+				m_projWidth = width;
+				m_projHeight = height;
+				m_stats.glCalls++;
+			} else {
+				m_stats.glCallsSkipped++;
+			}
+
+			setCapability(GL_SCISSOR_TEST, m_cache.scissor, false);
+			setCapability(GL_DEPTH_TEST, m_cache.depth, false);
+			setCapability(GL_CULL_FACE, m_cache.cull, false);
+			setCapability(GL_BLEND, m_cache.blend, true);
+			blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+			bindVertexArray(m_vao);
+			activeTexture(GL_TEXTURE0);
+			for (const Batch& b : m_batches) {
+				if (b.length <= 0) continue;
+				bindTexture(b.tex.id);
+
+				const size_t first = m_regionOffset + size_t(b.offset);
+				if (m_drawBaseInstance) {
+					m_drawBaseInstance(GL_TRIANGLE_STRIP, 0, 4, b.length, GLuint(first));
 				} else {
-					glUniform1i(m_uTexOn, 0);
+					pointAttributes(first);
+					glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, b.length);
 				}
+				m_stats.drawCalls++;
+				m_stats.glCalls++;
+			}
 
-				Rect sc = b.scissor.grow(1);
-				glScissor(sc.x, height - sc.h - sc.y, sc.w, sc.h);
-				if (b.length > 0) glDrawArrays(b.prim, b.offset, b.length);
+			// Marks the region busy until the GPU is done drawing from it
+			if (m_streamMode != StreamOrphan) {
+				m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				m_stats.glCalls++;
+			}
 
-				if (b.tex.id != 0) {
-					glBindTexture(GL_TEXTURE_2D, 0);
-				}
+			if (!m_hostOwnsState) {
+				bindTexture(0);
+				bindVertexArray(0);
+				useProgram(host.program);
+				setCapability(GL_SCISSOR_TEST, m_cache.scissor, host.scissor == 1);
+				setCapability(GL_DEPTH_TEST, m_cache.depth, host.depth == 1);
+				setCapability(GL_CULL_FACE, m_cache.cull, host.cull == 1);
+				setCapability(GL_BLEND, m_cache.blend, host.blend == 1);
+				blendFunc(host.blendSrcRGB, host.blendDstRGB, host.blendSrcAlpha, host.blendDstAlpha);
+				setViewport(host.viewport[0], host.viewport[1], host.viewport[2], host.viewport[3]);
 			}
 
-			glBindVertexArray(0);
-			glUseProgram(prog);
+			m_batches.clear();
+			m_instances.clear();
+		}
+
+		/**
+		 * @brief  Declares whether the host owns the GL state
+		 * @note   When it does, end() neither queries nor restores any state: it sets
+		 * 		   what it needs and leaves it bound, skipping whatever is already
+		 * 		   set from the previous frame. Call invalidateState() whenever
+		 * 		   the host changes GL state in between.
+		 * @param  owns: true to enable the mode
+		 * @retval None
+		 */
+		inline void setHostOwnsState(bool owns) {
+			m_hostOwnsState = owns;
+			invalidateState();
+		}
 
-			if (!hasScissor) glDisable(GL_SCISSOR_TEST);
-			if (hasDepth) glEnable(GL_DEPTH_TEST);
-			if (hasCull) glEnable(GL_CULL_FACE);
-			if (!hasBlend) glDisable(GL_BLEND);
-			else glBlendFunc(bsrc, bdest);
+		/// Forgets the shadowed GL state, the next frame sets everything again
+		inline void invalidateState() { m_cache = StateCache{}; }
 
-			m_batches.clear();
-			glViewport(vp[0], vp[1], vp[2], vp[3]);
+		inline void processCommand(const Command& cmd) override {
+			translate(cmd);
 		}
 
-		inline void processCommand(const Command& cmd) {
-			Glyph g;
-			g.tex.id = 0;
-			g.prim = 0xFF;
+		inline void processCommands(const Command* cmds, size_t count) override {
+			for (size_t i = 0; i < count; i++) translate(cmds[i]);
+		}
+
+	protected:
+		std::vector<Batch> m_batches;
+		std::vector<Instance> m_instances;
+
+		Texture m_font;
+
+		/**
+		 * @brief  Appends the instance of a command to the frame's instance array
+		 * @note   Makes no GL calls and allocates only when the array grows.
+		 * 		   Only images need a texture, everything else joins the
+		 * 		   current batch whatever texture it uses.
+		 * @param  cmd: The command to translate
+		 * @retval None
+		 */
+		inline void translate(const Command& cmd) {
+			const Color32 c = cmd.color;
+			const int x1 = cmd.points[0].x, y1 = cmd.points[0].y,
+					  x2 = cmd.points[1].x, y2 = cmd.points[1].y;
 
 			switch (cmd.type) {
 				case Command::CmdDrawLine: {
-					g.prim = GL_LINES;
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[0].y, 0, 0, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[1].y, 0, 0, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
+					emit(nullptr, Instance::KindLine, x1, y1, x2, y2, c);
 				} break;
 				case Command::CmdDrawRect: {
-					g.prim = GL_LINES;
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[0].y, 0, 0, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[0].y, 1, 0, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[0].y, 1, 0, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[1].y, 1, 1, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[1].y, 1, 1, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[1].y, 0, 1, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[1].y, 0, 1, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[0].y, 0, 0, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
+					// A one pixel border around nothing, the pixels SDL_RenderDrawRect covers
+					if (Instance* i = emitBox(x1, y1, x2, y2, Color32{ 0, 0, 0, 0 })) {
+						i->color2 = c;
+						i->border = 1;
+					}
 				} break;
 				case Command::CmdFillRect: {
-					g.prim = GL_TRIANGLES;
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[0].y, 0, 0, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[0].y, 1, 0, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[1].y, 1, 1, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[1].y, 1, 1, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[1].y, 0, 1, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[0].y, 0, 0, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
+					emitBox(x1, y1, x2, y2, c);
+				} break;
+				case Command::CmdDrawBox: {
+					if (Instance* i = emitBox(x1, y1, x2, y2, c, std::abs(int(cmd.box.shadowOffset)))) {
+						i->color2 = cmd.box.borderColor();
+						i->border = cmd.box.borderWidth;
+						i->shadowOffset = cmd.box.shadowOffset;
+						i->shadowAlpha = cmd.box.shadowAlpha;
+					}
 				} break;
 				case Command::CmdDrawImage: {
-					Texture* img = (Texture*) cmd.image;
-					float u1 = float(cmd.src.x) / img->w;
-					float v1 = float(cmd.src.y) / img->h;
-					float u2 = float(cmd.src.x + cmd.src.w) / img->w;
-					float v2 = float(cmd.src.y + cmd.src.h) / img->h;
-
-					g.prim = GL_TRIANGLES;
-					g.tex = *img;
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[0].y, u1, v1, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[0].y, u2, v1, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[1].y, u2, v2, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[1].x, cmd.points[1].y, u2, v2, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[1].y, u1, v2, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
-					g.vertices.push_back(Vert{ cmd.points[0].x, cmd.points[0].y, u1, v1, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a });
+					const Texture* img = (const Texture*) imageOf(cmd);
+					unsigned short u1 = unorm16(cmd.src.x, img->w), v1 = unorm16(cmd.src.y, img->h),
+								   u2 = unorm16(cmd.src.x + cmd.src.w, img->w), v2 = unorm16(cmd.src.y + cmd.src.h, img->h);
+					int qx1 = x1, qy1 = y1, qx2 = x2, qy2 = y2;
+					if (qx1 > qx2) { std::swap(qx1, qx2); std::swap(u1, u2); }
+					if (qy1 > qy2) { std::swap(qy1, qy2); std::swap(v1, v2); }
+					if (qx1 == qx2 || qy1 == qy2) break;
+
+					if (Instance* i = emit(img, Instance::KindQuad, qx1, qy1, qx2, qy2, c)) {
+						i->u1 = u1; i->v1 = v1;
+						i->u2 = u2; i->v2 = v2;
+					}
+				} break;
+				case Command::CmdDrawText: {
+					emitText(cmd, x1, y1, c);
 				} break;
 				case Command::CmdSetClip: {
-					int x = cmd.points[0].x,
-						y = cmd.points[0].y,
-						w = cmd.points[1].x - cmd.points[0].x,
-						h = cmd.points[1].y - cmd.points[0].y;
-					m_nextClip = Rect(x, y, w, h);
+					// Grown by one pixel, the area the scissor used to cover
+					m_clip = ClipBox{
+						clamp16(cmd.points[0].x - 1), clamp16(cmd.points[0].y - 1),
+						clamp16(cmd.points[1].x + 1), clamp16(cmd.points[1].y + 1)
+					};
 				} break;
 				case Command::CmdUnsetClip: {
-					int vp[4];
-					glGetIntegerv(GL_VIEWPORT, vp);
-					m_nextClip = Rect(vp[0], vp[1], vp[2], vp[3]);
+					m_clip = NoClip;
 				} break;
+				default: break;
 			}
-			g.scissor = m_nextClip;
-			m_glyphs.push_back(g);
+		}
+
+		/// Appends an untextured box, nullptr if it covers no pixels. The
+		/// shadow reaches margin pixels past it.
+		inline Instance* emitBox(int x1, int y1, int x2, int y2, Color32 c, int margin = 0) {
+			if (x1 > x2) std::swap(x1, x2);
+			if (y1 > y2) std::swap(y1, y2);
+			if (x1 == x2 || y1 == y2) return nullptr;
+			return emit(nullptr, Instance::KindBox, x1, y1, x2, y2, c, margin);
+		}
+
+		/**
+		 * @brief  Appends an instance clipped to the current clip, zeroing the
+		 * 		   fields its kind does not use
+		 * @param  tex: Texture, nullptr if the instance samples none
+		 * @param  kind: Instance::Kind
+		 * @param  x1, y1, x2, y2: Rect or line end points
+		 * @param  c: Color
+		 * @param  margin: Pixels the instance may draw past its points
+		 * @retval The new instance, nullptr if it lies outside the clip
+		 */
+		inline Instance* emit(const Texture* tex, byte kind, int x1, int y1, int x2, int y2, Color32 c, int margin = 0) {
+			if (outsideClip(std::min(x1, x2) - margin, std::min(y1, y2) - margin, std::max(x1, x2) + margin, std::max(y1, y2) + margin)) {
+				return nullptr;
+			}
+			Instance* i = allocate(tex);
+			*i = instance(kind, x1, y1, x2, y2, c);
+			return i;
+		}
+
+		/// Whether the bounds miss the current clip box, which without a clip
+		/// is the range the 16 bit instance coordinates can hold
+		inline bool outsideClip(int x1, int y1, int x2, int y2) const {
+			return x2 < m_clip.x1 || x1 > m_clip.x2 || y2 < m_clip.y1 || y1 > m_clip.y2;
+		}
+
+		/**
+		 * @brief  Appends a glyph quad per visible character of a CmdDrawText,
+		 * 		   all the shadows first
+		 * @note   Shadows never overlap the neighbouring glyphs, so drawing them
+		 * 		   all first looks the same as interleaving them
+		 * @retval None
+		 */
+		inline void emitText(const Command& cmd, int x, int y, Color32 c) {
+			const Texture* font = (const Texture*) imageOf(cmd);
+			std::string_view str = textOf(cmd);
+			if (outsideClip(x, y, x + int(str.size()) * 8, y + 17)) return;
+
+			// only the glyphs reaching into the clip box, so none ends up past
+			// what the 16 bit coordinates hold
+			const int first = std::max(0, floorDiv(m_clip.x1 - x, 8) - 1);
+			const int last = std::min(int(str.size()), floorDiv(m_clip.x2 - x, 8) + 1);
+			if (first >= last) return;
+			str = str.substr(size_t(first), size_t(last - first));
+			x += first * 8;
+
+			int visible = 0;
+			for (char ch : str) visible += fontGlyph(ch) != 0;
+			if (visible == 0) return;
+
+			const int passes = cmd.run.shadow ? 2 : 1;
+			Instance* out = allocate(font, visible * passes);
+			Instance glyph = instance(Instance::KindQuad, x, y, x + 8, y + 16, c);
+			glyph.v2 = unorm16(16, font->h);
+			for (int pass = 0; pass < passes; pass++) {
+				const bool shadow = pass + 1 < passes;
+				glyph.color = shadow ? Color32{ 0, 0, 0, 255 } : c;
+				glyph.y1 = clamp16(shadow ? y + 1 : y);
+				glyph.y2 = clamp16((shadow ? y + 1 : y) + 16);
+
+				int gx = x;
+				for (char ch : str) {
+					const int cell = fontGlyph(ch);
+					if (cell != 0) {
+						glyph.x1 = clamp16(gx);
+						glyph.x2 = clamp16(gx + 8);
+						glyph.u1 = unorm16(cell * 8, font->w);
+						glyph.u2 = unorm16(cell * 8 + 8, font->w);
+						*out++ = glyph;
+					}
+					gx += 8;
+				}
+			}
+		}
+
+		/// An instance with the current clip, the fields its kind does not use zeroed
+		inline Instance instance(byte kind, int x1, int y1, int x2, int y2, Color32 c) const {
+			Instance i;
+			i.x1 = clamp16(x1); i.y1 = clamp16(y1);
+			i.x2 = clamp16(x2); i.y2 = clamp16(y2);
+			i.u1 = i.v1 = i.u2 = i.v2 = 0;
+			i.color = c;
+			i.color2 = Color32{ 0, 0, 0, 0 };
+			i.cx1 = m_clip.x1; i.cy1 = m_clip.y1;
+			i.cx2 = m_clip.x2; i.cy2 = m_clip.y2;
+			i.kind = kind;
+			i.border = 0;
+			i.shadowAlpha = 0;
+			i.shadowOffset = 0;
+			return i;
+		}
+
+		/**
+		 * @brief  Reserves instances at the end of the array, opening a new
+		 * 		   batch when the texture changes
+		 * @param  tex: Texture, nullptr to join the current batch whatever its texture
+		 * @param  count: Number of instances
+		 * @retval Pointer to the first reserved instance
+		 */
+		inline Instance* allocate(const Texture* tex, int count = 1) {
+			if (m_batches.empty() || (tex && m_batches.back().tex.id != tex->id)) {
+				Batch b{};
+				b.offset = int(m_instances.size());
+				b.tex = tex ? *tex : m_font;
+				m_batches.push_back(b);
+			}
+			m_batches.back().length += count;
+
+			const size_t offset = m_instances.size();
+			m_instances.resize(offset + count);
+			return m_instances.data() + offset;
+		}
+
+		static inline short clamp16(int value) {
+			return short(std::min(32767, std::max(-32768, value)));
+		}
+
+		static inline unsigned short unorm16(int value, int size) {
+			const long long scaled = (value * 65535LL + size / 2) / size;
+			return (unsigned short) std::min(65535LL, std::max(0LL, scaled));
 		}
 
 	private:
-		Texture m_font;
-		GLuint m_vbo, m_vao, m_shader, m_uProj, m_uTex, m_uTexOn;
+		GLuint m_vbo{ 0 }, m_vao, m_shader, m_uProj;
+
+		GLADloadproc m_loader{ nullptr };
+		BufferStorageProc m_bufferStorage{ nullptr };
+		DrawArraysInstancedBaseInstanceProc m_drawBaseInstance{ nullptr };
+		GetProgramBinaryProc m_getProgramBinary{ nullptr };
+		ProgramBinaryProc m_programBinary{ nullptr };
+		ProgramParameteriProc m_programParameteri{ nullptr };
+
+		std::string m_programCache;
+
+		/// Header of the program cache file, followed by the binary
+		struct ProgramCacheHeader {
+			char magic[4];
+			uint32_t version;
+			uint64_t key;
+			uint32_t format;
+			uint32_t length;
+		};
+		static constexpr uint32_t ProgramCacheVersion = 1;
+
+		GL3StreamMode m_streamMode{ StreamAuto };
+		std::array<GLsync, SGUI_GL3_STREAM_REGIONS> m_fences{};
+		Instance* m_mapped{ nullptr };
+		size_t m_regionSize{ 0 }, m_regionOffset{ 0 };
+		size_t m_attribFirst{ 0 };	// instance the attributes point at, VAO state
+		int m_region{ 0 };
+
+		/// Shadow of the GL state end() touches, ~0 / -1 mean unknown
+		struct StateCache {
+			static constexpr GLuint Unknown = ~0u;
+			GLuint program{ Unknown }, vao{ Unknown }, texture{ Unknown }, arrayBuffer{ Unknown };
+			GLenum activeTexture{ 0 };
+			GLenum blendSrcRGB{ 0 }, blendDstRGB{ 0 }, blendSrcAlpha{ 0 }, blendDstAlpha{ 0 };
+			int blend{ -1 }, depth{ -1 }, cull{ -1 }, scissor{ -1 };
+			int viewport[4]{ -1, -1, -1, -1 };
+		};
+		StateCache m_cache{};
+		bool m_hostOwnsState{ false };
+		int m_projWidth{ -1 }, m_projHeight{ -1 };
+
+		struct ClipBox { short x1, y1, x2, y2; };
+		static constexpr ClipBox NoClip{ -32768, -32768, 32767, 32767 };
+		ClipBox m_clip{ NoClip };
+
+		/**
+		 * @brief  Queries the host state end() changes into the cache
+		 * @retval None
+		 */
+		inline void saveHostState() {
+			GLint value;
+			glGetIntegerv(GL_VIEWPORT, m_cache.viewport);
+			glGetIntegerv(GL_CURRENT_PROGRAM, &value); m_cache.program = GLuint(value);
+			glGetIntegerv(GL_BLEND_SRC_RGB, &value); m_cache.blendSrcRGB = GLenum(value);
+			glGetIntegerv(GL_BLEND_DST_RGB, &value); m_cache.blendDstRGB = GLenum(value);
+			glGetIntegerv(GL_BLEND_SRC_ALPHA, &value); m_cache.blendSrcAlpha = GLenum(value);
+			glGetIntegerv(GL_BLEND_DST_ALPHA, &value); m_cache.blendDstAlpha = GLenum(value);
+			m_cache.blend = glIsEnabled(GL_BLEND) ? 1 : 0;
+			m_cache.depth = glIsEnabled(GL_DEPTH_TEST) ? 1 : 0;
+			m_cache.cull = glIsEnabled(GL_CULL_FACE) ? 1 : 0;
+			m_cache.scissor = glIsEnabled(GL_SCISSOR_TEST) ? 1 : 0;
+			m_stats.glCalls += 10;
+		}
 
-		Rect m_nextClip{ 0, 0, 0, 0 };
+		inline void useProgram(GLuint program) {
+			if (m_cache.program == program) { m_stats.glCallsSkipped++; return; }
+			glUseProgram(program);
+			m_cache.program = program;
+			m_stats.glCalls++;
+		}
 
-		std::vector<Batch> m_batches;
-		std::vector<Glyph> m_glyphs;
+		inline void bindVertexArray(GLuint vao) {
+			if (m_cache.vao == vao) { m_stats.glCallsSkipped++; return; }
+			glBindVertexArray(vao);
+			m_cache.vao = vao;
+			m_stats.glCalls++;
+		}
+
+		inline void bindArrayBuffer(GLuint buffer) {
+			if (m_cache.arrayBuffer == buffer) { m_stats.glCallsSkipped++; return; }
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			m_cache.arrayBuffer = buffer;
+			m_stats.glCalls++;
+		}
+
+		inline void activeTexture(GLenum unit) {
+			if (m_cache.activeTexture == unit) { m_stats.glCallsSkipped++; return; }
+			glActiveTexture(unit);
+			m_cache.activeTexture = unit;
+			m_stats.glCalls++;
+		}
+
+		/// Binds to the active unit, which end() always keeps at GL_TEXTURE0
+		inline void bindTexture(GLuint texture) {
+			if (m_cache.texture == texture) { m_stats.glCallsSkipped++; return; }
+			glBindTexture(GL_TEXTURE_2D, texture);
+			m_cache.texture = texture;
+			m_stats.glCalls++;
+		}
+
+		inline void setCapability(GLenum cap, int& cached, bool enabled) {
+			if (cached == int(enabled)) { m_stats.glCallsSkipped++; return; }
+			if (enabled) glEnable(cap);
+			else glDisable(cap);
+			cached = int(enabled);
+			m_stats.glCalls++;
+		}
+
+		inline void blendFunc(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
+			if (m_cache.blendSrcRGB == srcRGB && m_cache.blendDstRGB == dstRGB &&
+				m_cache.blendSrcAlpha == srcAlpha && m_cache.blendDstAlpha == dstAlpha)
+			{
+				m_stats.glCallsSkipped++;
+				return;
+			}
+			glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+			m_cache.blendSrcRGB = srcRGB;
+			m_cache.blendDstRGB = dstRGB;
+			m_cache.blendSrcAlpha = srcAlpha;
+			m_cache.blendDstAlpha = dstAlpha;
+			m_stats.glCalls++;
+		}
+
+		inline void setViewport(int x, int y, int w, int h) {
+			int* vp = m_cache.viewport;
+			if (vp[0] == x && vp[1] == y && vp[2] == w && vp[3] == h) { m_stats.glCallsSkipped++; return; }
+			glViewport(x, y, w, h);
+			vp[0] = x; vp[1] = y; vp[2] = w; vp[3] = h;
+			m_stats.glCalls++;
+		}
+
+		inline bool hasExtension(const char* name) {
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+			for (GLint i = 0; i < count; i++) {
+				const char* ext = (const char*) glGetStringi(GL_EXTENSIONS, i);
+				if (ext && !std::strcmp(ext, name)) return true;
+			}
+			return false;
+		}
+
+		/**
+		 * @brief  Points the per instance attributes of the bound VAO at an instance
+		 * @note   Only needed without base instance support, skipped when unchanged
+		 * @param  first: Index of the instance in the whole buffer
+		 * @retval None
+		 */
+		inline void pointAttributes(size_t first) {
+			if (m_attribFirst == first) { m_stats.glCallsSkipped++; return; }
+			bindArrayBuffer(m_vbo);
+
+			const size_t base = first * sizeof(Instance);
+			const GLsizei stride = sizeof(Instance);
+			glVertexAttribPointer(0, 4, GL_SHORT, false, stride, (void*) (base + offsetof(Instance, x1)));
+			glVertexAttribPointer(1, 4, GL_UNSIGNED_SHORT, true, stride, (void*) (base + offsetof(Instance, u1)));
+			glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, true, stride, (void*) (base + offsetof(Instance, color)));
+			glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, true, stride, (void*) (base + offsetof(Instance, color2)));
+			glVertexAttribPointer(4, 4, GL_SHORT, false, stride, (void*) (base + offsetof(Instance, cx1)));
+			glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, stride, (void*) (base + offsetof(Instance, kind)));
+			m_attribFirst = first;
+			m_stats.glCalls += 6;
+		}
+
+		/**
+		 * @brief  (Re)creates the instance buffer with room for the given instances per region
+		 * @note   Falls back to StreamUnsynchronized if persistent mapping fails
+		 * @param  instances: Region capacity, in instances
+		 * @retval None
+		 */
+		inline void createStream(size_t instances) {
+			releaseStream();
+
+			const size_t regions = m_streamMode == StreamOrphan ? 1 : SGUI_GL3_STREAM_REGIONS;
+			const GLsizeiptr bytes = GLsizeiptr(instances * sizeof(Instance) * regions);
+			m_regionSize = instances;
+
+			glGenBuffers(1, &m_vbo);
+			glBindVertexArray(m_vao);
+			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+			m_cache.arrayBuffer = m_vbo;
+			if (m_streamMode == StreamPersistent) {
+				const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				m_bufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+				m_mapped = (Instance*) glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags);
+				if (m_mapped == nullptr) {
+					glBindVertexArray(0);
+					m_streamMode = StreamUnsynchronized;
+					createStream(instances);
+					return;
+				}
+			} else {
+				glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+			}
+
+			// Every attribute advances once per instance, the 4 corners come from gl_VertexID
+			for (GLuint i = 0; i < 6; i++) {
+				glEnableVertexAttribArray(i);
+				glVertexAttribDivisor(i, 1);
+			}
+			m_attribFirst = ~size_t(0);
+			pointAttributes(0);
+
+			glBindVertexArray(0);
+			m_cache.vao = 0;
+		}
+
+		inline void releaseStream() {
+			for (GLsync& fence : m_fences) {
+				if (fence) glDeleteSync(fence);
+				fence = nullptr;
+			}
+			if (m_vbo == 0) return;
+
+			if (m_mapped) {
+				glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+				m_mapped = nullptr;
+			}
+			glDeleteBuffers(1, &m_vbo);
+			m_vbo = 0;
+			m_cache.arrayBuffer = StateCache::Unknown;
+		}
+
+		/**
+		 * @brief  Blocks until the GPU is done reading a region
+		 * @note   Counted in FrameStats::uploadStalls when it actually waits
+		 * @param  region: Region index
+		 * @retval None
+		 */
+		inline void waitRegion(int region) {
+			GLsync& fence = m_fences[region];
+			if (!fence) return;
+
+			m_stats.glCalls += 2;
+			if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+				m_stats.uploadStalls++;
+				do {
+					m_stats.glCalls++;
+				} while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+			}
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		/**
+		 * @brief  Creates m_shader from the program cache, or compiles and links it
+		 * 		   and refreshes the cache
+		 * @param  vert: Vertex shader source
+		 * @param  frag: Fragment shader source
+		 * @retval None
+		 */
+		inline void buildProgram(const char* vert, const char* frag) {
+			uint64_t key = 0;
+			const bool cached = loadProgramBinaryProcs();
+			if (cached) {
+				key = programKey(vert, frag);
+				if (loadProgramBinary(key)) {
+					m_startupStats.programCacheHit = true;
+					return;
+				}
+			}
+
+			GLuint vs = createShader(vert, GL_VERTEX_SHADER);
+			GLuint fs = createShader(frag, GL_FRAGMENT_SHADER);
+
+			m_shader = glCreateProgram();
+			glAttachShader(m_shader, vs);
+			glAttachShader(m_shader, fs);
+			if (cached) m_programParameteri(m_shader, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			glLinkProgram(m_shader);
+
+			char log[1024];
+			glGetProgramInfoLog(m_shader, 1024, nullptr, log);
+			std::cerr << log << std::endl;
+
+			glDetachShader(m_shader, vs);
+			glDetachShader(m_shader, fs);
+			glDeleteShader(vs);
+			glDeleteShader(fs);
+
+			if (cached) saveProgramBinary(key);
+		}
+
+		/// Loads the program binary entry points, false if the cache can not be used
+		inline bool loadProgramBinaryProcs() {
+			if (m_programCache.empty() || m_loader == nullptr) return false;
+
+			const bool core = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1);
+			if (!core && !hasExtension("GL_ARB_get_program_binary")) return false;
+
+			m_getProgramBinary = (GetProgramBinaryProc) m_loader("glGetProgramBinary");
+			m_programBinary = (ProgramBinaryProc) m_loader("glProgramBinary");
+			m_programParameteri = (ProgramParameteriProc) m_loader("glProgramParameteri");
+			if (!m_getProgramBinary || !m_programBinary || !m_programParameteri) return false;
+
+			// Drivers may support the extension without any binary format
+			GLint formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			return formats > 0;
+		}
+
+		/// FNV-1a of the driver strings and the shader sources
+		static inline uint64_t programKey(const char* vert, const char* frag) {
+			const char* parts[] = {
+				(const char*) glGetString(GL_VENDOR),
+				(const char*) glGetString(GL_RENDERER),
+				(const char*) glGetString(GL_VERSION),
+				vert, frag
+			};
+
+			uint64_t hash = 14695981039346656037ull;
+			for (const char* part : parts) {
+				for (const char* c = part ? part : ""; ; c++) {
+					hash = (hash ^ byte(*c)) * 1099511628211ull;
+					if (*c == '\0') break;
+				}
+			}
+			return hash;
+		}
+
+		/**
+		 * @brief  Creates m_shader from the cache file
+		 * @param  key: Key the file must have been written with
+		 * @retval true if the driver accepted the cached binary
+		 */
+		inline bool loadProgramBinary(uint64_t key) {
+			std::ifstream in(m_programCache, std::ios::binary);
+			if (!in) return false;
+
+			ProgramCacheHeader header{};
+			if (!in.read((char*) &header, sizeof(header)) ||
+				std::memcmp(header.magic, "SGPB", 4) != 0 ||
+				header.version != ProgramCacheVersion ||
+				header.key != key ||
+				header.length == 0)
+			{
+				return false;
+			}
+
+			std::vector<char> binary(header.length);
+			if (!in.read(binary.data(), binary.size())) return false;
+
+			m_shader = glCreateProgram();
+			m_programBinary(m_shader, header.format, binary.data(), GLsizei(binary.size()));
+
+			// Drivers reject binaries from other versions even with a matching key
+			GLint linked = GL_FALSE;
+			glGetProgramiv(m_shader, GL_LINK_STATUS, &linked);
+			if (linked != GL_TRUE) {
+				glDeleteProgram(m_shader);
+				m_shader = 0;
+				return false;
+			}
+			return true;
+		}
+
+		/// Writes the linked m_shader to the cache file, failures are ignored
+		inline void saveProgramBinary(uint64_t key) {
+			GLint length = 0;
+			glGetProgramiv(m_shader, GL_PROGRAM_BINARY_LENGTH, &length);
+			if (length <= 0) return;
+
+			std::vector<char> binary(length);
+			GLenum format = 0;
+			GLsizei written = 0;
+			m_getProgramBinary(m_shader, length, &written, &format, binary.data());
+			if (written <= 0) return;
+
+			ProgramCacheHeader header{ { 'S', 'G', 'P', 'B' }, ProgramCacheVersion, key, uint32_t(format), uint32_t(written) };
+			std::ofstream out(m_programCache, std::ios::binary | std::ios::trunc);
+			out.write((const char*) &header, sizeof(header));
+			out.write(binary.data(), written);
+		}
 
 		inline GLuint createShader(const char* src, GLenum type) {
 			GLuint s = glCreateShader(type);
@@ -316,4 +1018,4 @@ void main() {
 }
 #endif
 
-#endif // SIMPLE_GUI_GL3_HPP
\ No newline at end of file
+#endif // SIMPLE_GUI_GL3_HPP
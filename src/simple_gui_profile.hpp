@@ -0,0 +1,148 @@
+#ifndef SIMPLE_GUI_PROFILE_HPP
+#define SIMPLE_GUI_PROFILE_HPP
+
+/**
+ * Scoped profiling markers.
+ *
+ * Define SGUI_PROFILING to enable them. Every thread then records its scopes
+ * into its own ring buffer, without locks. writeChromeTrace dumps all
+ * of them in the Chrome/Perfetto trace event format. Without SGUI_PROFILING,
+ * SGUI_PROFILE_SCOPE expands to nothing.
+ */
+
+#define SGUI_PROFILE_CONCAT_(a, b) a##b
+#define SGUI_PROFILE_CONCAT(a, b) SGUI_PROFILE_CONCAT_(a, b)
+
+#ifdef SGUI_PROFILING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+#ifndef SGUI_PROFILE_RING_SIZE
+#define SGUI_PROFILE_RING_SIZE (1 << 14)
+#endif
+
+#define SGUI_PROFILE_SCOPE(name) ::sgui::profile::Scope SGUI_PROFILE_CONCAT(sguiProfileScope, __LINE__)(name)
+
+namespace sgui {
+	namespace profile {
+		struct Event {
+			const char* name;
+			uint64_t start, end;
+		};
+
+		/// Single writer ring, owned by one thread and never freed so the
+		/// events outlive it.
+		struct Ring {
+			Event events[SGUI_PROFILE_RING_SIZE];
+			std::atomic<uint64_t> head{ 0 };
+			uint32_t thread{ 0 };
+			Ring* next{ nullptr };
+		};
+
+		inline uint64_t now() {
+			using namespace std::chrono;
+			return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+		}
+
+		inline std::atomic<Ring*>& rings() {
+			static std::atomic<Ring*> head{ nullptr };
+			return head;
+		}
+
+		inline Ring* registerRing() {
+			static std::atomic<uint32_t> threads{ 0 };
+			Ring* ring = new Ring();
+			ring->thread = ++threads;
+			ring->next = rings().load(std::memory_order_relaxed);
+			while (!rings().compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed));
+			return ring;
+		}
+
+		inline Ring& threadRing() {
+			thread_local Ring* ring = registerRing();
+			return *ring;
+		}
+
+		class Scope {
+		public:
+			inline explicit Scope(const char* name) : m_name(name), m_start(now()) {}
+
+			inline ~Scope() {
+				Ring& ring = threadRing();
+				const uint64_t head = ring.head.load(std::memory_order_relaxed);
+				ring.events[head % SGUI_PROFILE_RING_SIZE] = Event{ m_name, m_start, now() };
+				ring.head.store(head + 1, std::memory_order_release);
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator =(const Scope&) = delete;
+
+		private:
+			const char* m_name;
+			uint64_t m_start;
+		};
+
+		/**
+		 * @brief  Writes the recorded scopes as Chrome trace event JSON
+		 * @note   Call it while the profiled threads are idle (e.g. between
+		 * 		   frames), events being written during the dump may be torn
+		 * @param  out: The output stream
+		 * @retval None
+		 */
+		inline void writeChromeTrace(std::ostream& out) {
+			// timestamps count from the oldest event, in microseconds with nanosecond digits
+			uint64_t origin = UINT64_MAX;
+			for (Ring* ring = rings().load(std::memory_order_acquire); ring; ring = ring->next) {
+				const uint64_t head = ring->head.load(std::memory_order_acquire);
+				const uint64_t begin = head > SGUI_PROFILE_RING_SIZE ? head - SGUI_PROFILE_RING_SIZE : 0;
+				for (uint64_t i = begin; i < head; i++) origin = std::min(origin, ring->events[i % SGUI_PROFILE_RING_SIZE].start);
+			}
+
+			const std::ios_base::fmtflags flags = out.flags();
+			const std::streamsize precision = out.precision();
+			out << std::fixed << std::setprecision(3);
+
+			out << "{\"traceEvents\":[";
+			bool first = true;
+			for (Ring* ring = rings().load(std::memory_order_acquire); ring; ring = ring->next) {
+				const uint64_t head = ring->head.load(std::memory_order_acquire);
+				const uint64_t begin = head > SGUI_PROFILE_RING_SIZE ? head - SGUI_PROFILE_RING_SIZE : 0;
+				for (uint64_t i = begin; i < head; i++) {
+					const Event& e = ring->events[i % SGUI_PROFILE_RING_SIZE];
+					out << (first ? "\n" : ",\n")
+						<< "{\"name\":\"" << e.name << "\",\"cat\":\"sgui\",\"ph\":\"X\""
+						<< ",\"ts\":" << double(e.start - origin) / 1000.0
+						<< ",\"dur\":" << double(e.end - e.start) / 1000.0
+						<< ",\"pid\":1,\"tid\":" << ring->thread << "}";
+					first = false;
+				}
+			}
+			out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+
+			out.flags(flags);
+			out.precision(precision);
+		}
+
+		inline bool saveChromeTrace(const std::string& path) {
+			std::ofstream out(path);
+			if (!out) return false;
+			writeChromeTrace(out);
+			return bool(out);
+		}
+	}
+}
+
+#else
+
+#define SGUI_PROFILE_SCOPE(name)
+
+#endif // SGUI_PROFILING
+
+#endif // SIMPLE_GUI_PROFILE_HPP
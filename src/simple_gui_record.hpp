@@ -0,0 +1,214 @@
+#ifndef SIMPLE_GUI_RECORD_HPP
+#define SIMPLE_GUI_RECORD_HPP
+
+/**
+ * Input recording and replay.
+ *
+ * InputRecorder wraps the InputManager of a live session and writes every
+ * frame's time and input events to a file. InputReplayer feeds such a file
+ * back one frame per Gui::prepare(), so a session can be replayed against a
+ * headless renderer and its frame times compared across builds.
+ *
+ * The file holds a RecordingHeader, then per frame an InputFrameRecord
+ * followed by its InputEventRecords, in the byte order of the machine
+ * that wrote it.
+ */
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "simple_gui.hpp"
+
+namespace sgui {
+	struct RecordingHeader {
+		char magic[4];
+		uint32_t version;
+	};
+	static constexpr uint32_t RecordingVersion = 1;
+
+	struct InputFrameRecord {
+		int32_t time;			// InputManager::time() during the frame
+		uint32_t events;		// InputEventRecords that follow
+	};
+
+	struct InputEventRecord {
+		uint8_t type, key, length, reserved;
+		char text[4];
+		int32_t button, x, y, time;
+
+		static inline InputEventRecord from(const InputEvent& e) {
+			InputEventRecord r{ uint8_t(e.type), uint8_t(e.key), e.length, 0, {}, e.button, e.x, e.y, e.time };
+			std::memcpy(r.text, e.text, sizeof(r.text));
+			return r;
+		}
+
+		inline InputEvent event() const {
+			InputEvent e{};
+			e.type = InputEvent::Type(type);
+			e.key = Key(key);
+			e.length = length;
+			std::memcpy(e.text, text, sizeof(e.text));
+			e.button = button;
+			e.x = x;
+			e.y = y;
+			e.time = time;
+			return e;
+		}
+	};
+
+	/**
+	 * Passes another InputManager's events through, writing each frame to
+	 * a file. The time is sampled once per frame, so a replay sees the same
+	 * values the recorded session did.
+	 */
+	class InputRecorder : public InputManager {
+	public:
+		/**
+		 * @brief  Wraps an input manager
+		 * @note   Clipboard reads are not recorded, a replay pastes what was
+		 * 		   copied during the replay
+		 * @param  input: The input manager to record, owned by the recorder
+		 * @param  path: The file to write
+		 */
+		inline InputRecorder(InputManager* input, const std::string& path)
+			: m_input(input), m_out(path, std::ios::binary | std::ios::trunc)
+		{
+			const RecordingHeader header{ { 'S', 'G', 'I', 'R' }, RecordingVersion };
+			m_out.write((const char*) &header, sizeof(header));
+		}
+
+		inline void init(std::array<int, KeyCount>& keymap) override {
+			m_input->initKeymap();
+			for (int k = 0; k < KeyCount; k++) keymap[k] = m_input->key(Key(k));
+		}
+
+		inline int time() override { return m_time; }
+
+		inline void processEvents(void* udata) override {
+			m_input->processEvents(udata);
+		}
+
+		inline void setClipboardText(const std::string& text) override { m_input->setClipboardText(text); }
+		inline std::string getClipboardText() override { return m_input->getClipboardText(); }
+
+		inline void beginFrame() override {
+			// the wrapped manager may also be fed directly, take whatever it queued
+			m_input->beginFrame();
+			for (size_t i = 0; i < m_input->eventCount(); i++) queueEvent(m_input->event(i));
+			addDroppedEvents(m_input->droppedEvents());
+			m_input->clear();
+
+			InputManager::beginFrame();
+			m_time = m_input->time();
+
+			const InputFrameRecord frame{ m_time, uint32_t(eventCount()) };
+			m_out.write((const char*) &frame, sizeof(frame));
+			for (size_t i = 0; i < eventCount(); i++) {
+				const InputEventRecord record = InputEventRecord::from(event(i));
+				m_out.write((const char*) &record, sizeof(record));
+			}
+		}
+
+		/// Whether everything so far reached the file
+		inline bool good() const { return bool(m_out); }
+
+	private:
+		std::unique_ptr<InputManager> m_input;
+		std::ofstream m_out;
+		int m_time{ 0 };
+	};
+
+	/**
+	 * Plays a recording back, one recorded frame per Gui::prepare(). The
+	 * whole file is loaded up front, so replaying does no I/O.
+	 */
+	class InputReplayer : public InputManager {
+	public:
+		/**
+		 * @brief  Loads a recording
+		 * @param  path: The file written by an InputRecorder
+		 */
+		inline explicit InputReplayer(const std::string& path) {
+			std::ifstream in(path, std::ios::binary);
+			RecordingHeader header{};
+			if (!in.read((char*) &header, sizeof(header)) ||
+				std::memcmp(header.magic, "SGIR", 4) != 0 ||
+				header.version != RecordingVersion)
+			{
+				return;
+			}
+
+			in.seekg(0, std::ios::end);
+			const std::streamoff size = in.tellg();
+			in.seekg(sizeof(header));
+
+			InputFrameRecord frame{};
+			while (in.read((char*) &frame, sizeof(frame))) {
+				// a recorded frame never holds more than a full queue, and a
+				// corrupt count must not size the allocation
+				const std::streamoff remaining = size - in.tellg();
+				if (frame.events > InputManager::QueueSize ||
+					std::streamoff(frame.events * sizeof(InputEventRecord)) > remaining)
+				{
+					break;
+				}
+
+				const size_t first = m_events.size();
+				m_events.resize(first + frame.events);
+				if (!in.read((char*) (m_events.data() + first), frame.events * sizeof(InputEventRecord))) {
+					m_events.resize(first);
+					break;
+				}
+				m_frames.push_back(Frame{ frame.time, first, frame.events });
+			}
+			m_loaded = true;
+		}
+
+		inline void init(std::array<int, KeyCount>& keymap) override {
+			// the recorded events carry Keys already
+			for (int k = 0; k < KeyCount; k++) keymap[k] = k;
+		}
+
+		inline int time() override { return m_time; }
+		inline void processEvents(void* udata) override {}
+
+		inline void setClipboardText(const std::string& text) override { m_clipboard = text; }
+		inline std::string getClipboardText() override { return m_clipboard; }
+
+		inline void beginFrame() override {
+			if (m_next < m_frames.size()) {
+				const Frame& frame = m_frames[m_next++];
+				m_time = frame.time;
+				for (size_t i = 0; i < frame.count; i++) queueEvent(m_events[frame.first + i].event());
+			}
+			InputManager::beginFrame();
+		}
+
+		/// Whether the file was a recording, possibly cut short
+		inline bool loaded() const { return m_loaded; }
+
+		inline size_t frames() const { return m_frames.size(); }
+
+		/// Whether every recorded frame was played
+		inline bool finished() const { return m_next >= m_frames.size(); }
+
+	private:
+		struct Frame {
+			int time;
+			size_t first, count;
+		};
+
+		std::vector<Frame> m_frames;
+		std::vector<InputEventRecord> m_events;
+		size_t m_next{ 0 };
+		bool m_loaded{ false };
+
+		int m_time{ 0 };
+		std::string m_clipboard;
+	};
+}
+
+#endif // SIMPLE_GUI_RECORD_HPP
@@ -44,29 +44,22 @@ namespace sgui {
 			SDL_Event event = *((SDL_Event*)udata);
 			switch (event.type) {
 				case SDL_MOUSEMOTION:
-					m_mouseX = event.motion.x;
-					m_mouseY = event.motion.y;
+					queueMouseMove(event.motion.x, event.motion.y, event.motion.timestamp);
 					break;
 				case SDL_MOUSEBUTTONDOWN:
-					m_mouse[event.button.button].down = true;
-					m_mouse[event.button.button].pressed = true;
+					queueMouseButton(event.button.button, true, event.button.x, event.button.y, event.button.timestamp);
 					break;
 				case SDL_MOUSEBUTTONUP:	
-					m_mouse[event.button.button].down = false;
-					m_mouse[event.button.button].released = true;
+					queueMouseButton(event.button.button, false, event.button.x, event.button.y, event.button.timestamp);
+					break;
+				case SDL_KEYDOWN:
+					queueKey(translateKey(event.key.keysym.sym), true, event.key.timestamp);
+					break;
+				case SDL_KEYUP:
+					queueKey(translateKey(event.key.keysym.sym), false, event.key.timestamp);
 					break;
-				case SDL_KEYDOWN: {
-					Key k = translateKey(event.key.keysym.sym);
-					m_keyboard[k].down = true;
-					m_keyboard[k].pressed = true;
-				} break;
-				case SDL_KEYUP: {
-					Key k = translateKey(event.key.keysym.sym);
-					m_keyboard[k].down = false;
-					m_keyboard[k].released = true;
-				} break;
 				case SDL_TEXTINPUT:
-					m_char = event.text.text[0];
+					queueText(event.text.text, event.text.timestamp);
 					break;
 			}
 		}
@@ -81,21 +74,12 @@ namespace sgui {
 			SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
 		}
 
-		inline void* loadFont(const std::vector<byte>& pixels, int width, int height) override {
-			Uint32 rmask, gmask, bmask, amask;
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-    rmask = 0xff000000;
-    gmask = 0x00ff0000;
-    bmask = 0x0000ff00;
-    amask = 0x000000ff;
-#else
-    rmask = 0x000000ff;
-    gmask = 0x0000ff00;
-    bmask = 0x00ff0000;
-    amask = 0xff000000;
-#endif
-			SDL_Surface* surf = SDL_CreateRGBSurfaceFrom((void*) pixels.data(), width, height, 32, width * 4, rmask, gmask, bmask, amask);
-			SDL_SetColorKey(surf, 1, SDL_MapRGB(surf->format, 0, 0, 0));
+		inline void* loadFont(const byte* bits, int width, int height) override {
+			// Wraps the bits as they are, index 0 is keyed out
+			SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormatFrom((void*) bits, width, height, 1, (width + 7) / 8, SDL_PIXELFORMAT_INDEX1MSB);
+			const SDL_Color colors[] = { { 255, 255, 255, 0 }, { 255, 255, 255, 255 } };
+			SDL_SetPaletteColors(surf->format->palette, colors, 0, 2);
+			SDL_SetColorKey(surf, 1, 0);
 			font = SDL_CreateTextureFromSurface(ren, surf);
 			SDL_FreeSurface(surf);
 			return font;
@@ -108,24 +92,27 @@ namespace sgui {
 		inline void processCommand(const Command& cmd) {
 			switch (cmd.type) {
 				case Command::CmdDrawLine: {
-					SDL_SetRenderDrawColor(ren, cmd.color[0], cmd.color[1], cmd.color[2], cmd.color[3]);
+					SDL_SetRenderDrawColor(ren, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a);
 					SDL_RenderDrawLine(ren, cmd.points[0].x, cmd.points[0].y, cmd.points[1].x, cmd.points[1].y);
+					countDraw();
 				} break;
 				case Command::CmdDrawRect: {
 					SDL_Rect rc = {
 						cmd.points[0].x, cmd.points[0].y,
 						cmd.points[1].x - cmd.points[0].x, cmd.points[1].y - cmd.points[0].y
 					};
-					SDL_SetRenderDrawColor(ren, cmd.color[0], cmd.color[1], cmd.color[2], cmd.color[3]);
+					SDL_SetRenderDrawColor(ren, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a);
 					SDL_RenderDrawRect(ren, &rc);
+					countDraw();
 				} break;
 				case Command::CmdFillRect: {
 					SDL_Rect rc = {
 						cmd.points[0].x, cmd.points[0].y,
 						cmd.points[1].x - cmd.points[0].x, cmd.points[1].y - cmd.points[0].y
 					};
-					SDL_SetRenderDrawColor(ren, cmd.color[0], cmd.color[1], cmd.color[2], cmd.color[3]);
+					SDL_SetRenderDrawColor(ren, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a);
 					SDL_RenderFillRect(ren, &rc);
+					countDraw();
 				} break;
 				case Command::CmdDrawImage: {
 					SDL_Rect dst = {
@@ -135,11 +122,64 @@ namespace sgui {
 					SDL_Rect src = {
 						cmd.src.x, cmd.src.y, cmd.src.w, cmd.src.h
 					};
-					SDL_Texture* img = (SDL_Texture*)cmd.image;
+					SDL_Texture* img = (SDL_Texture*)imageOf(cmd);
 					SDL_SetTextureBlendMode(img, SDL_BLENDMODE_BLEND);
-					SDL_SetTextureAlphaMod(img, cmd.color[3]);
-					SDL_SetTextureColorMod(img, cmd.color[0], cmd.color[1], cmd.color[2]);
+					SDL_SetTextureAlphaMod(img, cmd.color.a);
+					SDL_SetTextureColorMod(img, cmd.color.r, cmd.color.g, cmd.color.b);
 					SDL_RenderCopy(ren, img, &src, &dst);
+					countDraw();
+				} break;
+				case Command::CmdDrawBox: {
+					SDL_Rect rc = {
+						cmd.points[0].x, cmd.points[0].y,
+						cmd.points[1].x - cmd.points[0].x, cmd.points[1].y - cmd.points[0].y
+					};
+					const Command::BoxStyle& box = cmd.box;
+					if (box.shadowOffset != 0 && box.shadowAlpha > 0) {
+						SDL_Rect shadow = { rc.x + box.shadowOffset, rc.y + box.shadowOffset, rc.w, rc.h };
+						SDL_SetRenderDrawColor(ren, 0, 0, 0, box.shadowAlpha);
+						SDL_RenderFillRect(ren, &shadow);
+						countDraw();
+					}
+					if (cmd.color.a > 0) {
+						SDL_SetRenderDrawColor(ren, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a);
+						SDL_RenderFillRect(ren, &rc);
+						countDraw();
+					}
+					SDL_SetRenderDrawColor(ren, box.border[0], box.border[1], box.border[2], box.border[3]);
+					for (int i = 0; i < box.borderWidth && rc.w > 0 && rc.h > 0; i++) {
+						SDL_RenderDrawRect(ren, &rc);
+						countDraw();
+						rc.x++; rc.y++;
+						rc.w -= 2; rc.h -= 2;
+					}
+				} break;
+				case Command::CmdDrawText: {
+					SDL_Texture* img = (SDL_Texture*)imageOf(cmd);
+					const std::string_view str = textOf(cmd);
+					SDL_SetTextureBlendMode(img, SDL_BLENDMODE_BLEND);
+
+					// All the shadows first, they never overlap the neighbouring glyphs
+					for (int pass = cmd.run.shadow ? 0 : 1; pass < 2; pass++) {
+						if (pass == 0) {
+							SDL_SetTextureAlphaMod(img, 255);
+							SDL_SetTextureColorMod(img, 0, 0, 0);
+						} else {
+							SDL_SetTextureAlphaMod(img, cmd.color.a);
+							SDL_SetTextureColorMod(img, cmd.color.r, cmd.color.g, cmd.color.b);
+						}
+
+						SDL_Rect dst = { cmd.points[0].x, cmd.points[0].y + (pass == 0 ? 1 : 0), 8, 16 };
+						for (char c : str) {
+							const int cell = fontGlyph(c);
+							if (cell != 0) {
+								SDL_Rect src = { cell * 8, 0, 8, 16 };
+								SDL_RenderCopy(ren, img, &src, &dst);
+								countDraw();
+							}
+							dst.x += 8;
+						}
+					}
 				} break;
 				case Command::CmdSetClip: {
 					SDL_Rect rc = {
@@ -155,6 +195,13 @@ namespace sgui {
 		SDL_Texture* font;
 		SDL_Renderer* ren;
 		SDL_Window* win;
+
+	private:
+		// SDL_Renderer batches internally, every call counts as its own batch here
+		inline void countDraw() {
+			m_stats.drawCalls++;
+			m_stats.batches++;
+		}
 	};
 }
 